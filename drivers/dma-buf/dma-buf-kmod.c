@@ -29,6 +29,13 @@ __FBSDID("$FreeBSD$");
 
 #include <sys/param.h>
 #include <sys/module.h>
+#include <sys/kernel.h>
+#include <sys/sysctl.h>
 
 MODULE_VERSION(dmabuf, 1);
 MODULE_DEPEND(dmabuf, linuxkpi, 1, 1, 1);
+
+SYSCTL_NODE(_hw, OID_AUTO, dmabuf, CTLFLAG_RW | CTLFLAG_MPSAFE, 0,
+    "DMA-BUF parameters");
+SYSCTL_NODE(_hw_dmabuf, OID_AUTO, fence, CTLFLAG_RW | CTLFLAG_MPSAFE, 0,
+    "Fence container allocation statistics");
@@ -25,12 +25,68 @@
  */
 
 #include <sys/param.h>
+#include <sys/counter.h>
+#include <sys/kernel.h>
+#include <sys/sysctl.h>
+
+#include <vm/uma.h>
 
 #include <linux/dma-fence-array.h>
 #include <linux/spinlock.h>
 
 MALLOC_DECLARE(M_DMABUF);
 
+/*
+ * Small arrays, which is what fence merging produces almost every time, are
+ * served from a zone sized for DMA_FENCE_ARRAY_INLINE callbacks. Larger ones
+ * still go through malloc(9).
+ */
+static uma_zone_t dma_fence_array_zone;
+
+SYSCTL_DECL(_hw_dmabuf_fence);
+static COUNTER_U64_DEFINE_EARLY(dma_fence_array_allocs);
+SYSCTL_COUNTER_U64(_hw_dmabuf_fence, OID_AUTO, array_allocs, CTLFLAG_RD,
+    &dma_fence_array_allocs, "Fence arrays allocated");
+static COUNTER_U64_DEFINE_EARLY(dma_fence_array_zone_allocs);
+SYSCTL_COUNTER_U64(_hw_dmabuf_fence, OID_AUTO, array_zone_allocs, CTLFLAG_RD,
+    &dma_fence_array_zone_allocs, "Fence arrays allocated from the zone");
+static COUNTER_U64_DEFINE_EARLY(dma_fence_array_inline);
+SYSCTL_COUNTER_U64(_hw_dmabuf_fence, OID_AUTO, array_inline, CTLFLAG_RD,
+    &dma_fence_array_inline, "Fence arrays storing their fences inline");
+
+static void
+dma_fence_array_zone_init(void *arg __unused)
+{
+	struct dma_fence_array *array;
+
+	dma_fence_array_zone = uma_zcreate("dma_fence_array",
+	    struct_size(array, callbacks, DMA_FENCE_ARRAY_INLINE),
+	    NULL, NULL, NULL, NULL, UMA_ALIGN_PTR, 0);
+}
+SYSINIT(dma_fence_array, SI_SUB_DRIVERS, SI_ORDER_FIRST,
+    dma_fence_array_zone_init, NULL);
+
+static void
+dma_fence_array_zone_fini(void *arg __unused)
+{
+
+	/* Wait for the RCU callbacks still holding arrays of the zone. */
+	rcu_barrier();
+	uma_zdestroy(dma_fence_array_zone);
+}
+SYSUNINIT(dma_fence_array, SI_SUB_DRIVERS, SI_ORDER_FIRST,
+    dma_fence_array_zone_fini, NULL);
+
+static void
+dma_fence_array_free_rcu(struct rcu_head *rcu)
+{
+	struct dma_fence *fence;
+
+	fence = container_of(rcu, struct dma_fence, rcu);
+	uma_zfree(dma_fence_array_zone,
+	    container_of(fence, struct dma_fence_array, base));
+}
+
 static const char *
 dma_fence_array_get_driver_name(struct dma_fence *fence)
 {
@@ -119,8 +175,13 @@ dma_fence_array_release(struct dma_fence *fence)
 	for (i = 0; i < array->num_fences; i++)
 		dma_fence_put(array->fences[i]);
 
-	free(array->fences, M_DMABUF);
-	dma_fence_free(fence);
+	if (array->fences != array->inline_fences)
+		free(array->fences, M_DMABUF);
+
+	if (array->num_fences <= DMA_FENCE_ARRAY_INLINE)
+		call_rcu(&fence->rcu, dma_fence_array_free_rcu);
+	else
+		dma_fence_free(fence);
 }
 
 struct dma_fence *
@@ -178,18 +239,37 @@ const struct dma_fence_ops dma_fence_array_ops = {
 };
 
 /*
- * Create a custom fence array
+ * Allocate a fence array for num_fences fences, which must be initialized
+ * with dma_fence_array_init() using the same number of fences.
  */
 struct dma_fence_array *
-dma_fence_array_create(int num_fences,
+dma_fence_array_alloc(int num_fences)
+{
+	struct dma_fence_array *array;
+
+	counter_u64_add(dma_fence_array_allocs, 1);
+	if (num_fences <= DMA_FENCE_ARRAY_INLINE) {
+		counter_u64_add(dma_fence_array_zone_allocs, 1);
+		return (uma_zalloc(dma_fence_array_zone, M_WAITOK | M_ZERO));
+	}
+
+	return (malloc(struct_size(array, callbacks, num_fences),
+	    M_DMABUF, M_WAITOK | M_ZERO));
+}
+
+/*
+ * Initialize a fence array from dma_fence_array_alloc(). fences may point to
+ * array->inline_fences if num_fences does not exceed DMA_FENCE_ARRAY_INLINE.
+ */
+void
+dma_fence_array_init(struct dma_fence_array *array, int num_fences,
     struct dma_fence **fences,
     u64 context, unsigned seqno,
     bool signal_on_any)
 {
-	struct dma_fence_array *array;
 
-	array = malloc(struct_size(array, callbacks, num_fences),
-	    M_DMABUF, M_WAITOK | M_ZERO);
+	if (fences == array->inline_fences)
+		counter_u64_add(dma_fence_array_inline, 1);
 
 	array->num_fences = num_fences;
 	spin_lock_init(&array->lock);
@@ -198,6 +278,22 @@ dma_fence_array_create(int num_fences,
 	init_irq_work(&array->work, irq_dma_fence_array_work);
 	atomic_set(&array->num_pending, signal_on_any ? 1 : num_fences);
 	array->fences = fences;
+}
+
+/*
+ * Create a custom fence array
+ */
+struct dma_fence_array *
+dma_fence_array_create(int num_fences,
+    struct dma_fence **fences,
+    u64 context, unsigned seqno,
+    bool signal_on_any)
+{
+	struct dma_fence_array *array;
+
+	array = dma_fence_array_alloc(num_fences);
+	dma_fence_array_init(array, num_fences, fences, context, seqno,
+	    signal_on_any);
 
 	return (array);
 }
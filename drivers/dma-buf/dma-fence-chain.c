@@ -25,6 +25,11 @@
  */
 
 #include <sys/param.h>
+#include <sys/counter.h>
+#include <sys/kernel.h>
+#include <sys/sysctl.h>
+
+#include <vm/uma.h>
 
 #include <linux/dma-fence-chain.h>
 
@@ -32,6 +37,69 @@ static bool dma_fence_chain_enable_signaling(struct dma_fence *fence);
 
 MALLOC_DECLARE(M_DMABUF);
 
+/*
+ * A chain node is allocated for every timeline point, so they are kept in
+ * their own zone where the per-CPU buckets serve most allocations and frees.
+ */
+static uma_zone_t dma_fence_chain_zone;
+
+SYSCTL_DECL(_hw_dmabuf_fence);
+static COUNTER_U64_DEFINE_EARLY(dma_fence_chain_allocs);
+SYSCTL_COUNTER_U64(_hw_dmabuf_fence, OID_AUTO, chain_allocs, CTLFLAG_RD,
+    &dma_fence_chain_allocs, "Fence chain nodes allocated");
+static COUNTER_U64_DEFINE_EARLY(dma_fence_chain_frees);
+SYSCTL_COUNTER_U64(_hw_dmabuf_fence, OID_AUTO, chain_frees, CTLFLAG_RD,
+    &dma_fence_chain_frees, "Fence chain nodes freed");
+
+static void
+dma_fence_chain_zone_init(void *arg __unused)
+{
+
+	dma_fence_chain_zone = uma_zcreate("dma_fence_chain",
+	    sizeof(struct dma_fence_chain), NULL, NULL, NULL, NULL,
+	    UMA_ALIGN_PTR, 0);
+}
+SYSINIT(dma_fence_chain, SI_SUB_DRIVERS, SI_ORDER_FIRST,
+    dma_fence_chain_zone_init, NULL);
+
+static void
+dma_fence_chain_zone_fini(void *arg __unused)
+{
+
+	/* Wait for the RCU callbacks still holding nodes of the zone. */
+	rcu_barrier();
+	uma_zdestroy(dma_fence_chain_zone);
+}
+SYSUNINIT(dma_fence_chain, SI_SUB_DRIVERS, SI_ORDER_FIRST,
+    dma_fence_chain_zone_fini, NULL);
+
+struct dma_fence_chain *
+dma_fence_chain_alloc(void)
+{
+
+	counter_u64_add(dma_fence_chain_allocs, 1);
+	return (uma_zalloc(dma_fence_chain_zone, M_WAITOK));
+}
+
+void
+dma_fence_chain_free(struct dma_fence_chain *chain)
+{
+
+	if (chain == NULL)
+		return;
+	counter_u64_add(dma_fence_chain_frees, 1);
+	uma_zfree(dma_fence_chain_zone, chain);
+}
+
+static void
+dma_fence_chain_free_rcu(struct rcu_head *rcu)
+{
+	struct dma_fence *fence;
+
+	fence = container_of(rcu, struct dma_fence, rcu);
+	dma_fence_chain_free(container_of(fence, struct dma_fence_chain, base));
+}
+
 static const char *
 dma_fence_chain_get_driver_name(struct dma_fence *fence)
 {
@@ -129,7 +197,8 @@ dma_fence_chain_release(struct dma_fence *fence)
 	}
 	dma_fence_put(prev);
 	dma_fence_put(chain->fence);
-	dma_fence_free(fence);
+	/* Readers may still dereference the node under rcu_read_lock(). */
+	call_rcu(&fence->rcu, dma_fence_chain_free_rcu);
 }
 
 
@@ -68,6 +68,7 @@ struct dma_fence *__dma_fence_unwrap_merge(unsigned int num_fences,
 					   struct dma_fence **fences,
 					   struct dma_fence_unwrap *iter)
 {
+	struct dma_fence *stack[DMA_FENCE_ARRAY_INLINE];
 	struct dma_fence_array *result;
 	struct dma_fence *tmp, **array;
 	ktime_t timestamp;
@@ -96,9 +97,14 @@ struct dma_fence *__dma_fence_unwrap_merge(unsigned int num_fences,
 	if (count == 0)
 		return dma_fence_allocate_private_stub(timestamp);
 
-	array = kmalloc_array(count, sizeof(*array), GFP_KERNEL);
-	if (!array)
-		return NULL;
+	/* Small merges are collected on the stack and stored inline. */
+	if (count <= ARRAY_SIZE(stack)) {
+		array = stack;
+	} else {
+		array = kmalloc_array(count, sizeof(*array), GFP_KERNEL);
+		if (!array)
+			return NULL;
+	}
 
 	/*
 	 * This trashes the input fence array and uses it as position for the
@@ -164,6 +170,19 @@ restart:
 		goto return_tmp;
 	}
 
+	if (array == stack) {
+		result = dma_fence_array_alloc(count);
+		if (!result) {
+			for (i = 0; i < count; ++i)
+				dma_fence_put(stack[i]);
+			return NULL;
+		}
+		memcpy(result->inline_fences, stack, count * sizeof(*stack));
+		dma_fence_array_init(result, count, result->inline_fences,
+				     dma_fence_context_alloc(1), 1, false);
+		return &result->base;
+	}
+
 	result = dma_fence_array_create(count, array,
 					dma_fence_context_alloc(1),
 					1, false);
@@ -174,7 +193,8 @@ restart:
 	return &result->base;
 
 return_tmp:
-	kfree(array);
+	if (array != stack)
+		kfree(array);
 	return tmp;
 }
 EXPORT_SYMBOL_GPL(__dma_fence_unwrap_merge);
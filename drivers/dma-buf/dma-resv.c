@@ -36,10 +36,20 @@
 #include <linux/dma-resv.h>
 #include <linux/dma-fence-array.h>
 #include <linux/export.h>
+#include <linux/hash.h>
 #include <linux/mm.h>
 #include <linux/sched/mm.h>
 #include <linux/mmu_notifier.h>
 #include <linux/seq_file.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
+
+#ifdef __FreeBSD__
+#include <sys/param.h>
+#include <sys/counter.h>
+#include <sys/kernel.h>
+#include <sys/sysctl.h>
+#endif
 
 /**
  * DOC: Reservation Object Overview
@@ -60,12 +70,73 @@ EXPORT_SYMBOL(reservation_ww_class);
 /* Mask for the lower fence pointer bits */
 #define DMA_RESV_LIST_MASK	0x3
 
+/*
+ * Lists reserved for at most this many fences are searched linearly when a
+ * fence is added. Larger lists carry a hash index keyed by fence context.
+ */
+#define DMA_RESV_LIST_INLINE	8
+
 struct dma_resv_list {
 	struct rcu_head rcu;
 	u32 num_fences, max_fences;
+	/*
+	 * Open addressed index from fence context to table slot + 1, only
+	 * present for lists larger than DMA_RESV_LIST_INLINE. The index is
+	 * only used by writers holding the dma_resv lock, RCU readers walk
+	 * the table as before.
+	 */
+	u32 hash_mask;
+	u32 *hash;
+	/* Fences added since the last scan for signaled fences. */
+	u32 num_added;
+	/* Scan again once num_added reaches this. */
+	u32 scan_at;
 	struct dma_fence __rcu *table[];
 };
 
+/*
+ * Signaled fences are only dropped from indexed lists when the list is
+ * reallocated. To keep long lived shared objects from piling up signaled
+ * fences, dma_resv_reserve_fences() rescans the list once as many fences as
+ * it holds were added, and compacts it when a sizeable part has signaled.
+ * Objects growing an indexed list are additionally queued for a background
+ * pass that compacts them even when nobody adds fences anymore.
+ */
+static unsigned int dma_resv_prune_interval_ms = 1000;
+
+static LIST_HEAD(dma_resv_prune_list);
+static DEFINE_SPINLOCK(dma_resv_prune_lock);
+static DECLARE_WAIT_QUEUE_HEAD(dma_resv_prune_wait);
+
+static void dma_resv_prune_worker(struct work_struct *work);
+static DECLARE_DELAYED_WORK(dma_resv_prune_work, dma_resv_prune_worker);
+
+#ifdef __FreeBSD__
+SYSCTL_DECL(_hw_dmabuf);
+static SYSCTL_NODE(_hw_dmabuf, OID_AUTO, resv, CTLFLAG_RW | CTLFLAG_MPSAFE, 0,
+    "Reservation object fence list pruning");
+SYSCTL_UINT(_hw_dmabuf_resv, OID_AUTO, prune_interval_ms, CTLFLAG_RWTUN,
+    &dma_resv_prune_interval_ms, 0,
+    "Interval of the background fence list compaction in ms, 0 disables it");
+
+static COUNTER_U64_DEFINE_EARLY(dma_resv_prune_inline);
+SYSCTL_COUNTER_U64(_hw_dmabuf_resv, OID_AUTO, prune_inline, CTLFLAG_RD,
+    &dma_resv_prune_inline, "Fence lists compacted while reserving");
+static COUNTER_U64_DEFINE_EARLY(dma_resv_prune_background);
+SYSCTL_COUNTER_U64(_hw_dmabuf_resv, OID_AUTO, prune_background, CTLFLAG_RD,
+    &dma_resv_prune_background, "Fence lists compacted in the background");
+static COUNTER_U64_DEFINE_EARLY(dma_resv_prune_fences_before);
+SYSCTL_COUNTER_U64(_hw_dmabuf_resv, OID_AUTO, prune_fences_before, CTLFLAG_RD,
+    &dma_resv_prune_fences_before, "Sum of list lengths before compaction");
+static COUNTER_U64_DEFINE_EARLY(dma_resv_prune_fences_after);
+SYSCTL_COUNTER_U64(_hw_dmabuf_resv, OID_AUTO, prune_fences_after, CTLFLAG_RD,
+    &dma_resv_prune_fences_after, "Sum of list lengths after compaction");
+
+#define	dma_resv_prune_stat(name, n)	counter_u64_add(dma_resv_##name, n)
+#else
+#define	dma_resv_prune_stat(name, n)	do { } while (0)
+#endif
+
 /* Extract the fence and usage flags from an RCU protected entry in the list. */
 static void dma_resv_list_entry(struct dma_resv_list *list, unsigned int index,
 				struct dma_resv *resv, struct dma_fence **fence,
@@ -95,25 +166,105 @@ static void dma_resv_list_set(struct dma_resv_list *list,
  * Allocate a new dma_resv_list and make sure to correctly initialize
  * max_fences.
  */
-static struct dma_resv_list *dma_resv_list_alloc(unsigned int max_fences)
+static struct dma_resv_list *dma_resv_list_alloc(unsigned int max_fences,
+						 gfp_t gfp)
 {
 	struct dma_resv_list *list;
+	unsigned int hash_size;
 	size_t size;
 
-	/* Round up to the next kmalloc bucket size. */
-	size = kmalloc_size_roundup(struct_size(list, table, max_fences));
+	if (max_fences <= DMA_RESV_LIST_INLINE) {
+		/* Round up to the next kmalloc bucket size. */
+		size = kmalloc_size_roundup(struct_size(list, table,
+							max_fences));
 
-	list = kmalloc(size, GFP_KERNEL);
+		list = kmalloc(size, gfp);
+		if (!list)
+			return NULL;
+
+		/* Given the resulting bucket size, recalculated max_fences. */
+		list->max_fences = (size - offsetof(typeof(*list), table)) /
+			sizeof(*list->table);
+		list->hash_mask = 0;
+		list->hash = NULL;
+		list->num_added = 0;
+		list->scan_at = 0;
+		return list;
+	}
+
+	/* Keep the index at most half full so probe sequences stay short. */
+	hash_size = roundup_pow_of_two(max_fences * 2);
+	size = struct_size(list, table, max_fences) +
+		hash_size * sizeof(*list->hash);
+
+	list = kmalloc(size, gfp);
 	if (!list)
 		return NULL;
 
-	/* Given the resulting bucket size, recalculated max_fences. */
-	list->max_fences = (size - offsetof(typeof(*list), table)) /
-		sizeof(*list->table);
+	list->max_fences = max_fences;
+	list->hash_mask = hash_size - 1;
+	list->hash = (u32 *)&list->table[max_fences];
+	list->num_added = 0;
+	list->scan_at = DMA_RESV_LIST_INLINE;
+	memset(list->hash, 0, hash_size * sizeof(*list->hash));
 
 	return list;
 }
 
+/*
+ * Find the index entry for @context, either the one pointing to the most
+ * recently added fence of that context or the empty entry to fill in.
+ */
+static u32 *dma_resv_list_hash_find(struct dma_resv_list *list,
+				    struct dma_resv *resv, u64 context)
+{
+	u32 i = hash_64(context, fls(list->hash_mask));
+
+	for (; list->hash[i]; i = (i + 1) & list->hash_mask) {
+		struct dma_fence *fence;
+
+		dma_resv_list_entry(list, list->hash[i] - 1, resv, &fence,
+				    NULL);
+		if (fence->context == context)
+			break;
+	}
+	return &list->hash[i];
+}
+
+/* Recreate the context index after the table was filled or rewritten. */
+static void dma_resv_list_hash_rebuild(struct dma_resv_list *list,
+				       struct dma_resv *resv)
+{
+	unsigned int i;
+
+	if (!list->hash)
+		return;
+
+	memset(list->hash, 0, (list->hash_mask + 1) * sizeof(*list->hash));
+	for (i = 0; i < list->num_fences; ++i) {
+		struct dma_fence *fence;
+
+		dma_resv_list_entry(list, i, resv, &fence, NULL);
+		*dma_resv_list_hash_find(list, resv, fence->context) = i + 1;
+	}
+}
+
+/* Count the fences of @list which haven't signaled yet. */
+static unsigned int dma_resv_list_live(struct dma_resv_list *list,
+				       struct dma_resv *resv)
+{
+	unsigned int i, live = 0;
+
+	for (i = 0; i < list->num_fences; ++i) {
+		struct dma_fence *fence;
+
+		dma_resv_list_entry(list, i, resv, &fence, NULL);
+		if (!dma_fence_is_signaled(fence))
+			++live;
+	}
+	return live;
+}
+
 /* Free a dma_resv_list and make sure to drop all references. */
 static void dma_resv_list_free(struct dma_resv_list *list)
 {
@@ -140,6 +291,9 @@ void dma_resv_init(struct dma_resv *obj)
 	ww_mutex_init(&obj->lock, &reservation_ww_class);
 
 	RCU_INIT_POINTER(obj->fences, NULL);
+	INIT_LIST_HEAD(&obj->prune_link);
+	obj->prune_queued = false;
+	obj->prune_busy = false;
 }
 EXPORT_SYMBOL(dma_resv_init);
 
@@ -153,6 +307,21 @@ void dma_resv_fini(struct dma_resv *obj)
 	 * This object should be dead and all references must have
 	 * been released to it, so no need to be protected with rcu.
 	 */
+	if (obj->prune_queued) {
+		/*
+		 * The worker only touches an object while it is marked busy,
+		 * so once it is not busy and off the queue it is done with.
+		 */
+		spin_lock(&dma_resv_prune_lock);
+		while (obj->prune_busy) {
+			spin_unlock(&dma_resv_prune_lock);
+			wait_event(dma_resv_prune_wait,
+				   !READ_ONCE(obj->prune_busy));
+			spin_lock(&dma_resv_prune_lock);
+		}
+		list_del_init(&obj->prune_link);
+		spin_unlock(&dma_resv_prune_lock);
+	}
 	dma_resv_list_free(rcu_dereference_protected(obj->fences, true));
 	ww_mutex_destroy(&obj->lock);
 }
@@ -165,45 +334,18 @@ static inline struct dma_resv_list *dma_resv_fences_list(struct dma_resv *obj)
 	return rcu_dereference_check(obj->fences, dma_resv_held(obj));
 }
 
-/**
- * dma_resv_reserve_fences - Reserve space to add fences to a dma_resv object.
- * @obj: reservation object
- * @num_fences: number of fences we want to add
- *
- * Should be called before dma_resv_add_fence().  Must be called with @obj
- * locked through dma_resv_lock().
- *
- * Note that the preallocated slots need to be re-reserved if @obj is unlocked
- * at any time before calling dma_resv_add_fence(). This is validated when
- * CONFIG_DEBUG_MUTEXES is enabled.
- *
- * RETURNS
- * Zero for success, or -errno
+/*
+ * Replace the fence list of @obj with a new one able to hold @max fences,
+ * dropping the references to the already signaled fences of @old.
  */
-int dma_resv_reserve_fences(struct dma_resv *obj, unsigned int num_fences)
+static int dma_resv_list_realloc(struct dma_resv *obj,
+				 struct dma_resv_list *old, unsigned int max,
+				 gfp_t gfp)
 {
-	struct dma_resv_list *old, *new;
-	unsigned int i, j, k, max;
-
-	dma_resv_assert_held(obj);
-
-	/* Driver and component code should never call this function with
-	 * num_fences=0. If they do it usually points to bugs when calculating
-	 * the number of needed fences dynamically.
-	 */
-	if (WARN_ON(!num_fences))
-		return -EINVAL;
-
-	old = dma_resv_fences_list(obj);
-	if (old && old->max_fences) {
-		if ((old->num_fences + num_fences) <= old->max_fences)
-			return 0;
-		max = max(old->num_fences + num_fences, old->max_fences * 2);
-	} else {
-		max = max(4ul, roundup_pow_of_two(num_fences));
-	}
+	struct dma_resv_list *new;
+	unsigned int i, j, k;
 
-	new = dma_resv_list_alloc(max);
+	new = dma_resv_list_alloc(max, gfp);
 	if (!new)
 		return -ENOMEM;
 
@@ -224,6 +366,9 @@ int dma_resv_reserve_fences(struct dma_resv *obj, unsigned int num_fences)
 			dma_resv_list_set(new, j++, fence, usage);
 	}
 	new->num_fences = j;
+	if (new->hash)
+		new->scan_at = max_t(u32, j, DMA_RESV_LIST_INLINE);
+	dma_resv_list_hash_rebuild(new, obj);
 
 	/*
 	 * We are not changing the effective set of fences here so can
@@ -238,6 +383,9 @@ int dma_resv_reserve_fences(struct dma_resv *obj, unsigned int num_fences)
 	if (!old)
 		return 0;
 
+	dma_resv_prune_stat(prune_fences_before, old->num_fences);
+	dma_resv_prune_stat(prune_fences_after, new->num_fences);
+
 	/* Drop the references to the signaled fences */
 	for (i = k; i < max; ++i) {
 		struct dma_fence *fence;
@@ -250,6 +398,181 @@ int dma_resv_reserve_fences(struct dma_resv *obj, unsigned int num_fences)
 
 	return 0;
 }
+
+/*
+ * Check if an indexed list accumulated enough signaled fences to be worth
+ * compacting. Unless @idle is set the scan only runs once as many fences as
+ * the list held at the last scan were added, which keeps its cost amortized
+ * constant per dma_resv_add_fence() no matter if the adds replace or append.
+ */
+static bool dma_resv_list_should_prune(struct dma_resv_list *list,
+				       struct dma_resv *obj, bool idle)
+{
+	unsigned int live;
+
+	if (!list->hash || (!idle && list->num_added < list->scan_at))
+		return false;
+
+	list->num_added = 0;
+	list->scan_at = max_t(u32, list->num_fences, DMA_RESV_LIST_INLINE);
+	live = dma_resv_list_live(list, obj);
+
+	return live < list->num_fences &&
+		list->num_fences - live >= list->num_fences / 4;
+}
+
+/*
+ * Hand @obj to the background worker, must be called with @obj locked.
+ * @prune_queued stays set once the object was queued, dma_resv_fini() uses
+ * it to know that it has to check the queue.
+ */
+static void dma_resv_prune_queue(struct dma_resv *obj)
+{
+	unsigned int interval = READ_ONCE(dma_resv_prune_interval_ms);
+
+	if (!interval)
+		return;
+
+	obj->prune_queued = true;
+	spin_lock(&dma_resv_prune_lock);
+	if (list_empty(&obj->prune_link))
+		list_add_tail(&obj->prune_link, &dma_resv_prune_list);
+	spin_unlock(&dma_resv_prune_lock);
+	schedule_delayed_work(&dma_resv_prune_work, msecs_to_jiffies(interval));
+}
+
+/*
+ * Compact the fence lists of the queued objects. An object is dequeued once
+ * it was compacted, or its list is empty or has shrunk back below the
+ * indexed size, and requeued when its list grows again. Objects which are
+ * contended or still mostly busy are retried on the next pass.
+ *
+ * The prune lock only covers the queue itself. The object being compacted is
+ * marked busy and moved to a private list first, dma_resv_fini() waits for
+ * that mark to clear before the object goes away. The object is trylocked, so
+ * the worker never waits for a contended one.
+ */
+static void dma_resv_prune_worker(struct work_struct *work)
+{
+	unsigned int interval = READ_ONCE(dma_resv_prune_interval_ms);
+	struct dma_resv *obj;
+	LIST_HEAD(busy);
+
+	spin_lock(&dma_resv_prune_lock);
+	while ((obj = list_first_entry_or_null(&dma_resv_prune_list,
+					       struct dma_resv,
+					       prune_link))) {
+		struct dma_resv_list *list;
+		bool done = false;
+
+		list_move_tail(&obj->prune_link, &busy);
+		obj->prune_busy = true;
+		spin_unlock(&dma_resv_prune_lock);
+
+		if (dma_resv_trylock(obj)) {
+			list = dma_resv_fences_list(obj);
+			if (!list || !list->hash || !list->num_fences) {
+				done = true;
+			} else if (dma_resv_list_should_prune(list, obj, true) &&
+				   !dma_resv_list_realloc(obj, list,
+							  list->max_fences,
+							  GFP_KERNEL)) {
+				dma_resv_prune_stat(prune_background, 1);
+				done = true;
+			}
+			dma_resv_unlock(obj);
+		}
+
+		spin_lock(&dma_resv_prune_lock);
+		if (done)
+			list_del_init(&obj->prune_link);
+		WRITE_ONCE(obj->prune_busy, false);
+		spin_unlock(&dma_resv_prune_lock);
+
+		wake_up_all(&dma_resv_prune_wait);
+		cond_resched();
+		spin_lock(&dma_resv_prune_lock);
+	}
+	list_splice(&busy, &dma_resv_prune_list);
+	if (!list_empty(&dma_resv_prune_list) && interval)
+		schedule_delayed_work(&dma_resv_prune_work,
+				      msecs_to_jiffies(interval));
+	spin_unlock(&dma_resv_prune_lock);
+}
+
+static void __exit dma_resv_prune_exit(void)
+{
+	cancel_delayed_work_sync(&dma_resv_prune_work);
+}
+module_exit(dma_resv_prune_exit);
+
+/**
+ * dma_resv_reserve_fences - Reserve space to add fences to a dma_resv object.
+ * @obj: reservation object
+ * @num_fences: number of fences we want to add
+ *
+ * Should be called before dma_resv_add_fence().  Must be called with @obj
+ * locked through dma_resv_lock().
+ *
+ * Note that the preallocated slots need to be re-reserved if @obj is unlocked
+ * at any time before calling dma_resv_add_fence(). This is validated when
+ * CONFIG_DEBUG_MUTEXES is enabled.
+ *
+ * RETURNS
+ * Zero for success, or -errno
+ */
+int dma_resv_reserve_fences(struct dma_resv *obj, unsigned int num_fences)
+{
+	struct dma_resv_list *old;
+	unsigned int max;
+	int ret;
+
+	dma_resv_assert_held(obj);
+
+	/* Driver and component code should never call this function with
+	 * num_fences=0. If they do it usually points to bugs when calculating
+	 * the number of needed fences dynamically.
+	 */
+	if (WARN_ON(!num_fences))
+		return -EINVAL;
+
+	old = dma_resv_fences_list(obj);
+	if (old && old->max_fences) {
+		if ((old->num_fences + num_fences) <= old->max_fences) {
+			if (!dma_resv_list_should_prune(old, obj, false))
+				return 0;
+
+			/* Failing to compact is fine, the slots are there */
+			if (!dma_resv_list_realloc(obj, old, old->max_fences,
+						   GFP_KERNEL))
+				dma_resv_prune_stat(prune_inline, 1);
+			return 0;
+		}
+		if (old->hash)
+			/*
+			 * Indexed lists never reuse the slots of signaled
+			 * fences of other contexts, so a full list can be
+			 * mostly signaled. Size the new one from what the copy
+			 * keeps rather than doubling on every fill.
+			 */
+			max = roundup_pow_of_two(max(dma_resv_list_live(old, obj) +
+						     num_fences, 4u));
+		else
+			max = max(old->num_fences + num_fences,
+				  old->max_fences * 2);
+	} else {
+		max = max(4ul, roundup_pow_of_two(num_fences));
+	}
+
+	ret = dma_resv_list_realloc(obj, old, max, GFP_KERNEL);
+	if (ret)
+		return ret;
+
+	if (max > DMA_RESV_LIST_INLINE)
+		dma_resv_prune_queue(obj);
+
+	return 0;
+}
 EXPORT_SYMBOL(dma_resv_reserve_fences);
 
 #ifdef CONFIG_DEBUG_MUTEXES
@@ -288,9 +611,11 @@ EXPORT_SYMBOL(dma_resv_reset_max_fences);
 void dma_resv_add_fence(struct dma_resv *obj, struct dma_fence *fence,
 			enum dma_resv_usage usage)
 {
+	enum dma_resv_usage old_usage;
 	struct dma_resv_list *fobj;
 	struct dma_fence *old;
 	unsigned int i, count;
+	u32 *slot;
 
 	dma_fence_get(fence);
 
@@ -304,9 +629,35 @@ void dma_resv_add_fence(struct dma_resv *obj, struct dma_fence *fence,
 	fobj = dma_resv_fences_list(obj);
 	count = fobj->num_fences;
 
-	for (i = 0; i < count; ++i) {
-		enum dma_resv_usage old_usage;
+	if (fobj->hash) {
+		/*
+		 * Only the latest fence of the same context is a candidate
+		 * for replacement, signaled fences of other contexts are
+		 * dropped when the list is reallocated.
+		 */
+		fobj->num_added++;
+		slot = dma_resv_list_hash_find(fobj, obj, fence->context);
+		if (*slot) {
+			i = *slot - 1;
+			dma_resv_list_entry(fobj, i, obj, &old, &old_usage);
+			if ((old_usage >= usage &&
+			     dma_fence_is_later_or_same(fence, old)) ||
+			    dma_fence_is_signaled(old)) {
+				dma_resv_list_set(fobj, i, fence, usage);
+				dma_fence_put(old);
+				return;
+			}
+		}
 
+		BUG_ON(fobj->num_fences >= fobj->max_fences);
+		*slot = count + 1;
+		dma_resv_list_set(fobj, count, fence, usage);
+		/* pointer update must be visible before we extend the num_fences */
+		smp_store_mb(fobj->num_fences, count + 1);
+		return;
+	}
+
+	for (i = 0; i < count; ++i) {
 		dma_resv_list_entry(fobj, i, obj, &old, &old_usage);
 		if ((old->context == fence->context && old_usage >= usage &&
 		     dma_fence_is_later_or_same(fence, old)) ||
@@ -360,6 +711,8 @@ void dma_resv_replace_fences(struct dma_resv *obj, uint64_t context,
 		dma_resv_list_set(list, i, dma_fence_get(replacement), usage);
 		dma_fence_put(old);
 	}
+	if (list)
+		dma_resv_list_hash_rebuild(list, obj);
 }
 EXPORT_SYMBOL(dma_resv_replace_fences);
 
@@ -533,7 +886,8 @@ int dma_resv_copy_fences(struct dma_resv *dst, struct dma_resv *src)
 		if (dma_resv_iter_is_restarted(&cursor)) {
 			dma_resv_list_free(list);
 
-			list = dma_resv_list_alloc(cursor.num_fences);
+			list = dma_resv_list_alloc(cursor.num_fences,
+						   GFP_KERNEL);
 			if (!list) {
 				dma_resv_iter_end(&cursor);
 				return -ENOMEM;
@@ -547,6 +901,9 @@ int dma_resv_copy_fences(struct dma_resv *dst, struct dma_resv *src)
 	}
 	dma_resv_iter_end(&cursor);
 
+	if (list)
+		dma_resv_list_hash_rebuild(list, NULL);
+
 	list = rcu_replace_pointer(dst->fences, list, dma_resv_held(dst));
 	dma_resv_list_free(list);
 	return 0;
@@ -263,6 +263,8 @@ extern int amdgpu_sg_display;
 extern int amdgpu_umsch_mm;
 extern int amdgpu_seamless;
 extern int amdgpu_umsch_mm_fwlog;
+extern int amdgpu_ib_pool_ring;
+extern int amdgpu_vram_bg_clear;
 
 extern int amdgpu_user_partt_mode;
 extern int amdgpu_agp;
@@ -73,9 +73,11 @@ int amdgpu_bo_list_create(struct amdgpu_device *adev, struct drm_file *filp,
 {
 	unsigned last_entry = 0, first_userptr = num_entries;
 	struct amdgpu_bo_list_entry *array;
+	struct drm_gem_object **gobjs;
 	struct amdgpu_bo_list *list;
 	uint64_t total_size = 0;
 	unsigned i;
+	u32 *handles;
 	int r;
 
 	list = kvzalloc(struct_size(list, entries, num_entries), GFP_KERNEL);
@@ -87,27 +89,35 @@ int amdgpu_bo_list_create(struct amdgpu_device *adev, struct drm_file *filp,
 	list->num_entries = num_entries;
 	array = list->entries;
 
+	gobjs = kvmalloc_array(num_entries, sizeof(*gobjs), GFP_KERNEL);
+	handles = kvmalloc_array(num_entries, sizeof(*handles), GFP_KERNEL);
+	if (!gobjs || !handles) {
+		kvfree(handles);
+		r = -ENOMEM;
+		goto error_free;
+	}
+
+	/* Look up all handles under a single table lock round trip */
+	for (i = 0; i < num_entries; ++i)
+		handles[i] = info[i].bo_handle;
+	r = drm_gem_objects_lookup_array(filp, handles, num_entries, gobjs);
+	kvfree(handles);
+	if (r)
+		goto error_free;
+
 	for (i = 0; i < num_entries; ++i) {
 		struct amdgpu_bo_list_entry *entry;
-		struct drm_gem_object *gobj;
 		struct amdgpu_bo *bo;
 		struct mm_struct *usermm;
 
-		gobj = drm_gem_object_lookup(filp, info[i].bo_handle);
-		if (!gobj) {
-			r = -ENOENT;
-			goto error_free;
-		}
-
-		bo = amdgpu_bo_ref(gem_to_amdgpu_bo(gobj));
-		drm_gem_object_put(gobj);
+		bo = amdgpu_bo_ref(gem_to_amdgpu_bo(gobjs[i]));
 
 		usermm = amdgpu_ttm_tt_get_usermm(bo->tbo.ttm);
 		if (usermm) {
 			if (usermm != current->mm) {
 				amdgpu_bo_unref(&bo);
 				r = -EPERM;
-				goto error_free;
+				goto error_put;
 			}
 			entry = &array[--first_userptr];
 		} else {
@@ -129,6 +139,10 @@ int amdgpu_bo_list_create(struct amdgpu_device *adev, struct drm_file *filp,
 		trace_amdgpu_bo_list_set(list, bo);
 	}
 
+	for (i = 0; i < num_entries; ++i)
+		drm_gem_object_put(gobjs[i]);
+	kvfree(gobjs);
+
 	list->first_userptr = first_userptr;
 	sort(array, last_entry, sizeof(struct amdgpu_bo_list_entry),
 	     amdgpu_bo_list_entry_cmp, NULL);
@@ -139,11 +153,15 @@ int amdgpu_bo_list_create(struct amdgpu_device *adev, struct drm_file *filp,
 	*result = list;
 	return 0;
 
-error_free:
+error_put:
+	for (i = 0; i < num_entries; ++i)
+		drm_gem_object_put(gobjs[i]);
 	for (i = 0; i < last_entry; ++i)
 		amdgpu_bo_unref(&array[i].bo);
 	for (i = first_userptr; i < num_entries; ++i)
 		amdgpu_bo_unref(&array[i].bo);
+error_free:
+	kvfree(gobjs);
 	kvfree(list);
 	return r;
 
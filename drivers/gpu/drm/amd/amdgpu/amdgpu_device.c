@@ -4543,8 +4543,10 @@ void amdgpu_device_fini_hw(struct amdgpu_device *adev)
 	}
 	amdgpu_fence_driver_hw_fini(adev);
 
-	if (adev->mman.initialized)
+	if (adev->mman.initialized) {
+		ttm_device_flush_delayed(&adev->mman.bdev);
 		drain_workqueue(adev->mman.bdev.wq);
+	}
 
 	if (adev->pm.sysfs_initialized)
 		amdgpu_pm_sysfs_fini(adev);
@@ -224,6 +224,8 @@ int amdgpu_agp = -1; /* auto */
 int amdgpu_wbrf = -1;
 int amdgpu_damage_clips = -1; /* auto */
 int amdgpu_umsch_mm_fwlog;
+int amdgpu_ib_pool_ring;
+int amdgpu_vram_bg_clear;
 
 static void amdgpu_drv_delayed_reset_work_handler(struct work_struct *work);
 
@@ -1008,6 +1010,23 @@ module_param_named(umsch_mm, amdgpu_umsch_mm, int, 0444);
 MODULE_PARM_DESC(umsch_mm_fwlog, "Enable umschfw log(0 = disable (default value), 1 = enable)");
 module_param_named(umsch_mm_fwlog, amdgpu_umsch_mm_fwlog, int, 0444);
 
+/**
+ * DOC: ib_pool_ring (int)
+ * Suballocate IBs in ring mode, without taking the pool lock on submission.
+ * Pool space is then only reused in allocation order, so a long running job
+ * can make later submissions wait for it.
+ */
+MODULE_PARM_DESC(ib_pool_ring, "Lock-free ring mode IB pools (0 = disable (default value), 1 = enable)");
+module_param_named(ib_pool_ring, amdgpu_ib_pool_ring, int, 0444);
+
+/**
+ * DOC: vram_bg_clear (int)
+ * Clear freed VRAM while the copy engine is idle, so that allocations asking
+ * for cleared VRAM can skip the clear.
+ */
+MODULE_PARM_DESC(vram_bg_clear, "Clear freed VRAM in the background (0 = disable (default value), 1 = enable)");
+module_param_named(vram_bg_clear, amdgpu_vram_bg_clear, int, 0444);
+
 /**
  * DOC: smu_pptable_id (int)
  * Used to override pptable id. id = 0 use VBIOS pptable.
@@ -59,7 +59,15 @@ int amdgpu_sa_bo_manager_init(struct amdgpu_device *adev,
 	}
 
 	memset(sa_manager->cpu_ptr, 0, size);
-	drm_suballoc_manager_init(&sa_manager->base, size, suballoc_align);
+	if (amdgpu_ib_pool_ring) {
+		/* Falls back to the default mode on failure */
+		if (drm_suballoc_manager_init_ring(&sa_manager->base, size,
+						   suballoc_align))
+			dev_warn(adev->dev, "ring mode sa manager unavailable\n");
+	} else {
+		drm_suballoc_manager_init(&sa_manager->base, size,
+					  suballoc_align);
+	}
 	return r;
 }
 
@@ -2130,6 +2130,12 @@ void amdgpu_ttm_set_buffer_funcs_status(struct amdgpu_device *adev, bool enable)
 			goto error_free_entity;
 		}
 	} else {
+		/*
+		 * Clear the flag first, frees racing with the cancel may queue
+		 * the clear work again and it must find nothing to do.
+		 */
+		WRITE_ONCE(adev->mman.buffer_funcs_enabled, false);
+		cancel_delayed_work_sync(&adev->mman.vram_mgr.clear_work);
 		drm_sched_entity_destroy(&adev->mman.high_pr);
 		drm_sched_entity_destroy(&adev->mman.low_pr);
 		dma_fence_put(man->move);
@@ -2310,6 +2316,8 @@ int amdgpu_ttm_clear_buffer(struct amdgpu_bo *bo,
 		u64 size;
 
 		if (amdgpu_res_cleared(&cursor)) {
+			atomic64_add(cursor.size,
+				     &adev->mman.vram_mgr.clear_skipped);
 			amdgpu_res_next(&cursor, cursor.size);
 			continue;
 		}
@@ -2329,6 +2337,7 @@ int amdgpu_ttm_clear_buffer(struct amdgpu_bo *bo,
 
 		dma_fence_put(*fence);
 		*fence = next;
+		atomic64_add(size, &adev->mman.vram_mgr.clear_issued);
 
 		amdgpu_res_next(&cursor, size);
 	}
@@ -2338,6 +2347,53 @@ err:
 	return r;
 }
 
+/**
+ * amdgpu_ttm_clear_vram - clear VRAM not backing any buffer
+ * @adev: amdgpu device pointer
+ * @offset: byte offset into VRAM
+ * @size: number of bytes to clear
+ * @fence: dma_fence signaling the end of the clear
+ *
+ * Clear a range of VRAM the caller holds directly from the VRAM manager,
+ * e.g. free memory taken out for background clearing.
+ *
+ * Returns:
+ * 0 for success or a negative error code on failure.
+ */
+int amdgpu_ttm_clear_vram(struct amdgpu_device *adev, u64 offset, u64 size,
+			  struct dma_fence **fence)
+{
+	struct amdgpu_ring *ring = adev->mman.buffer_funcs_ring;
+	u64 addr = amdgpu_ttm_domain_start(adev, TTM_PL_VRAM) + offset;
+	int r = 0;
+
+	if (!adev->mman.buffer_funcs_enabled)
+		return -EINVAL;
+
+	*fence = dma_fence_get_stub();
+
+	mutex_lock(&adev->mman.gtt_window_lock);
+	while (size) {
+		struct dma_fence *next = NULL;
+		/* Never clear more than 256MiB at once to avoid timeouts */
+		u64 cur = min(size, 256ULL << 20);
+
+		r = amdgpu_ttm_fill_mem(ring, 0, addr, cur, NULL, &next,
+					false, true);
+		if (r)
+			break;
+
+		dma_fence_put(*fence);
+		*fence = next;
+
+		addr += cur;
+		size -= cur;
+	}
+	mutex_unlock(&adev->mman.gtt_window_lock);
+
+	return r;
+}
+
 int amdgpu_fill_buffer(struct amdgpu_bo *bo,
 			uint32_t src_data,
 			struct dma_resv *resv,
@@ -203,6 +203,34 @@ static ssize_t amdgpu_mem_info_vram_vendor(struct device *dev,
 	}
 }
 
+/**
+ * DOC: mem_info_vram_fragmentation
+ *
+ * The amdgpu driver provides a sysfs API for reporting how fragmented the
+ * free VRAM is
+ * The file mem_info_vram_fragmentation is used for this and returns the
+ * share of free VRAM, in thousandths, that is unusable for 2MiB allocations
+ */
+static ssize_t amdgpu_mem_info_vram_fragmentation_show(struct device *dev,
+						       struct device_attribute *attr,
+						       char *buf)
+{
+	struct drm_device *ddev = dev_get_drvdata(dev);
+	struct amdgpu_device *adev = drm_to_adev(ddev);
+	struct amdgpu_vram_mgr *mgr = &adev->mman.vram_mgr;
+	unsigned int order, frag;
+
+	if (adev->gmc.is_app_apu)
+		return sysfs_emit(buf, "0\n");
+
+	mutex_lock(&mgr->lock);
+	order = ilog2(SZ_2M) - ilog2(mgr->mm.chunk_size);
+	frag = drm_buddy_fragmentation(&mgr->mm, min(order, mgr->mm.max_order));
+	mutex_unlock(&mgr->lock);
+
+	return sysfs_emit(buf, "%u\n", frag);
+}
+
 static DEVICE_ATTR(mem_info_vram_total, S_IRUGO,
 		   amdgpu_mem_info_vram_total_show, NULL);
 static DEVICE_ATTR(mem_info_vis_vram_total, S_IRUGO,
@@ -213,6 +241,8 @@ static DEVICE_ATTR(mem_info_vis_vram_used, S_IRUGO,
 		   amdgpu_mem_info_vis_vram_used_show, NULL);
 static DEVICE_ATTR(mem_info_vram_vendor, S_IRUGO,
 		   amdgpu_mem_info_vram_vendor, NULL);
+static DEVICE_ATTR(mem_info_vram_fragmentation, S_IRUGO,
+		   amdgpu_mem_info_vram_fragmentation_show, NULL);
 
 static struct attribute *amdgpu_vram_mgr_attributes[] = {
 	&dev_attr_mem_info_vram_total.attr,
@@ -220,6 +250,7 @@ static struct attribute *amdgpu_vram_mgr_attributes[] = {
 	&dev_attr_mem_info_vram_used.attr,
 	&dev_attr_mem_info_vis_vram_used.attr,
 	&dev_attr_mem_info_vram_vendor.attr,
+	&dev_attr_mem_info_vram_fragmentation.attr,
 	NULL
 };
 
@@ -307,6 +338,10 @@ static void amdgpu_vram_mgr_do_reserve(struct ttm_resource_manager *man)
 					   DRM_BUDDY_RANGE_ALLOCATION))
 			continue;
 
+		/* Reserved pages never move, see amdgpu_vram_mgr_block_movable() */
+		list_for_each_entry(block, &rsv->allocated, link)
+			block->private = NULL;
+
 		block = amdgpu_vram_mgr_first_block(&rsv->allocated);
 		if (!block)
 			continue;
@@ -349,6 +384,7 @@ int amdgpu_vram_mgr_reserve_range(struct amdgpu_vram_mgr *mgr,
 
 	mutex_lock(&mgr->lock);
 	list_add_tail(&rsv->blocks, &mgr->reservations_pending);
+	drm_buddy_cache_drain(&mgr->cache);
 	amdgpu_vram_mgr_do_reserve(&mgr->manager);
 	mutex_unlock(&mgr->lock);
 
@@ -435,6 +471,340 @@ static int amdgpu_dummy_vram_mgr_new(struct ttm_resource_manager *man,
 	return -ENOSPC;
 }
 
+/* Buffers moved out of the way by one compaction pass, at most. */
+#define AMDGPU_VRAM_MGR_COMPACT_BOS	32
+/* Minimum time between two compaction passes. */
+#define AMDGPU_VRAM_MGR_COMPACT_INTERVAL	msecs_to_jiffies(500)
+
+struct amdgpu_vram_mgr_compact {
+	struct drm_buddy *mm;
+	struct ttm_buffer_object *bos[AMDGPU_VRAM_MGR_COMPACT_BOS];
+	unsigned int count;
+	u64 used;	/* bytes allocated inside the range */
+	u64 size;	/* bytes of the collected buffers */
+};
+
+/*
+ * Blocks point back to their resource while it's alive. Reserved pages,
+ * cached blocks and allocations still in flight have no owner yet and are
+ * never moved.
+ */
+static bool amdgpu_vram_mgr_block_movable(struct drm_buddy_block *block,
+					  void *arg)
+{
+	struct amdgpu_vram_mgr_resource *vres = block->private;
+	struct ttm_buffer_object *tbo;
+
+	if (!vres || !vres->base.bo)
+		return false;
+
+	tbo = vres->base.bo;
+	return tbo->type != ttm_bo_type_kernel && !tbo->pin_count &&
+	       !(ttm_to_amdgpu_bo(tbo)->flags & AMDGPU_GEM_CREATE_VRAM_CONTIGUOUS);
+}
+
+static void amdgpu_vram_mgr_compact_collect(struct drm_buddy_block *block,
+					    void *arg)
+{
+	struct amdgpu_vram_mgr_resource *vres = block->private;
+	struct amdgpu_vram_mgr_compact *c = arg;
+	struct ttm_buffer_object *tbo;
+	unsigned int i;
+
+	c->used += drm_buddy_block_size(c->mm, block);
+	if (!vres || !vres->base.bo || c->count == ARRAY_SIZE(c->bos))
+		return;
+
+	tbo = vres->base.bo;
+	for (i = 0; i < c->count; i++)
+		if (c->bos[i] == tbo)
+			return;
+
+	if (ttm_bo_get_unless_zero(tbo)) {
+		c->bos[c->count++] = tbo;
+		c->size += tbo->base.size;
+	}
+}
+
+static int amdgpu_vram_mgr_compact_move(struct amdgpu_vram_mgr *mgr,
+					struct ttm_buffer_object *tbo,
+					u64 start, u64 end)
+{
+	/* Never wait for the GPU, busy buffers are simply left in place. */
+	struct ttm_operation_ctx ctx = { .no_wait_gpu = true };
+	struct ttm_place places[2] = {};
+	struct ttm_placement placement = { .placement = places };
+	int r;
+
+	if (!dma_resv_trylock(tbo->base.resv))
+		return -EBUSY;
+
+	if (tbo->pin_count || !tbo->resource ||
+	    tbo->resource->mem_type != TTM_PL_VRAM) {
+		r = -EBUSY;
+		goto out;
+	}
+
+	/*
+	 * Anywhere in VRAM but the range being compacted, and only into free
+	 * space: TTM never evicts for a desired placement.
+	 */
+	if (start) {
+		places[placement.num_placement].lpfn = start >> PAGE_SHIFT;
+		places[placement.num_placement].flags = TTM_PL_FLAG_DESIRED;
+		places[placement.num_placement++].mem_type = TTM_PL_VRAM;
+	}
+	if (end < mgr->manager.size) {
+		places[placement.num_placement].fpfn = end >> PAGE_SHIFT;
+		places[placement.num_placement].flags = TTM_PL_FLAG_DESIRED;
+		places[placement.num_placement++].mem_type = TTM_PL_VRAM;
+	}
+
+	/* An empty placement would drop the backing store altogether. */
+	if (!placement.num_placement) {
+		r = -ENOSPC;
+		goto out;
+	}
+
+	r = ttm_bo_validate(tbo, &placement, &ctx);
+out:
+	dma_resv_unlock(tbo->base.resv);
+	return r;
+}
+
+/**
+ * amdgpu_vram_mgr_compact - make room for a contiguous allocation
+ *
+ * @mgr: amdgpu_vram_mgr pointer
+ * @order: buddy order of the allocation
+ *
+ * Picks the aligned range of @order with the least memory allocated, all of
+ * it by movable buffers, and migrates those buffers elsewhere in VRAM so the
+ * range can merge back into a single free block. Buffers are only moved into
+ * free VRAM, nothing is evicted to make room for them; the pass is skipped if
+ * the free space outside the range can't hold them.
+ *
+ * Returns:
+ * The number of buffers moved, or a negative error code.
+ */
+int amdgpu_vram_mgr_compact(struct amdgpu_vram_mgr *mgr, unsigned int order)
+{
+	struct drm_buddy *mm = &mgr->mm;
+	struct amdgpu_vram_mgr_compact c = { .mm = mm };
+	unsigned int i, moved = 0;
+	u64 start, end;
+	int r;
+
+	mutex_lock(&mgr->lock);
+	order = min(order, mm->max_order);
+	/* Cached blocks would have no owner to move. */
+	drm_buddy_cache_disable(&mgr->cache);
+	r = drm_buddy_compact_target(mm, order, amdgpu_vram_mgr_block_movable,
+				     NULL, &start);
+	if (!r) {
+		end = start + (mm->chunk_size << order);
+		drm_buddy_for_each_allocated(mm, start, end,
+					     amdgpu_vram_mgr_compact_collect,
+					     &c);
+		/* Free VRAM outside the range must fit what's moved out. */
+		if (mm->avail - (end - start - c.used) < c.size)
+			r = -ENOSPC;
+	}
+	drm_buddy_cache_enable(&mgr->cache);
+	mutex_unlock(&mgr->lock);
+
+	if (r) {
+		for (i = 0; i < c.count; i++)
+			ttm_bo_put(c.bos[i]);
+		atomic64_inc(&mgr->compact_failed);
+		return r;
+	}
+
+	for (i = 0; i < c.count; i++) {
+		if (!amdgpu_vram_mgr_compact_move(mgr, c.bos[i], start, end))
+			moved++;
+		ttm_bo_put(c.bos[i]);
+	}
+
+	atomic64_inc(&mgr->compactions);
+	atomic64_add(moved, &mgr->compact_moves);
+
+	return moved;
+}
+
+static void amdgpu_vram_mgr_compact_work(struct work_struct *work)
+{
+	struct amdgpu_vram_mgr *mgr =
+		container_of(work, struct amdgpu_vram_mgr, compact_work);
+
+	amdgpu_vram_mgr_compact(mgr, READ_ONCE(mgr->compact_order));
+}
+
+#define AMDGPU_VRAM_CLEAR_BATCH	SZ_64M
+#define AMDGPU_VRAM_CLEAR_DELAY	msecs_to_jiffies(100)
+
+/*
+ * Clear freed VRAM in batches while the buffer funcs ring is idle, so that
+ * AMDGPU_GEM_CREATE_VRAM_CLEARED allocations later find cleared blocks and
+ * skip their clear. The batch is taken out of the buddy while being cleared,
+ * so this backs off unless plenty of VRAM is free.
+ */
+static void amdgpu_vram_mgr_clear_work(struct work_struct *work)
+{
+	struct amdgpu_vram_mgr *mgr =
+		container_of(work, struct amdgpu_vram_mgr, clear_work.work);
+	struct amdgpu_device *adev = to_amdgpu_device(mgr);
+	struct drm_buddy_block *block, *tmp;
+	struct drm_buddy *mm = &mgr->mm;
+	struct dma_fence *fence = NULL;
+	LIST_HEAD(cleared);
+	LIST_HEAD(blocks);
+	u64 size, bytes = 0;
+	int r = 0;
+
+	if (!READ_ONCE(adev->mman.buffer_funcs_enabled) || adev->in_suspend)
+		return;
+
+	if (amdgpu_fence_count_emitted(adev->mman.buffer_funcs_ring)) {
+		schedule_delayed_work(&mgr->clear_work,
+				      AMDGPU_VRAM_CLEAR_DELAY);
+		return;
+	}
+
+	mutex_lock(&mgr->lock);
+	size = min_t(u64, round_down(mm->avail - mm->clear_avail, SZ_2M),
+		     AMDGPU_VRAM_CLEAR_BATCH);
+	if (!size || mm->avail < 2 * AMDGPU_VRAM_CLEAR_BATCH ||
+	    drm_buddy_alloc_blocks(mm, 0, mm->size, size, SZ_2M, &blocks, 0)) {
+		mutex_unlock(&mgr->lock);
+		return;
+	}
+	list_for_each_entry(block, &blocks, link)
+		block->private = NULL;
+	mutex_unlock(&mgr->lock);
+
+	list_for_each_entry_safe(block, tmp, &blocks, link) {
+		struct dma_fence *next = NULL;
+
+		if (!amdgpu_vram_mgr_is_cleared(block)) {
+			r = amdgpu_ttm_clear_vram(adev,
+						  amdgpu_vram_mgr_block_start(block),
+						  amdgpu_vram_mgr_block_size(block),
+						  &next);
+			/* Clears execute in order, wait for the last one */
+			if (next) {
+				dma_fence_put(fence);
+				fence = next;
+			}
+			if (r)
+				break;
+
+			bytes += amdgpu_vram_mgr_block_size(block);
+		}
+		list_move_tail(&block->link, &cleared);
+	}
+
+	if (fence) {
+		dma_fence_wait(fence, false);
+		if (fence->error) {
+			list_splice_init(&cleared, &blocks);
+			bytes = 0;
+			r = fence->error;
+		}
+		dma_fence_put(fence);
+	}
+
+	mutex_lock(&mgr->lock);
+	drm_buddy_free_list(mm, &cleared, DRM_BUDDY_CLEARED);
+	drm_buddy_free_list(mm, &blocks, 0);
+	amdgpu_vram_mgr_do_reserve(&mgr->manager);
+	mutex_unlock(&mgr->lock);
+
+	atomic64_add(bytes, &mgr->bg_cleared);
+
+	/* Keep going while there was dirty memory to clear */
+	if (!r && bytes)
+		schedule_delayed_work(&mgr->clear_work,
+				      AMDGPU_VRAM_CLEAR_DELAY);
+}
+
+/*
+ * Small allocations without placement restrictions are served from the
+ * per-CPU block cache, so they don't serialize on the manager lock.
+ */
+static struct drm_buddy_block *
+amdgpu_vram_mgr_cache_get(struct amdgpu_vram_mgr *mgr,
+			  struct ttm_buffer_object *tbo,
+			  struct amdgpu_vram_mgr_resource *vres)
+{
+	u64 size = vres->base.size;
+	struct drm_buddy_block *block;
+	unsigned int order;
+
+	if (vres->flags || !is_power_of_2(size) ||
+	    size < mgr->default_page_size ||
+	    ((u64)tbo->page_alignment << PAGE_SHIFT) > size)
+		return NULL;
+
+	order = ilog2(size) - ilog2(mgr->mm.chunk_size);
+	if (order >= DRM_BUDDY_CACHE_ORDERS)
+		return NULL;
+
+	block = drm_buddy_cache_get(&mgr->cache, order);
+	if (block)
+		return block;
+
+	mutex_lock(&mgr->lock);
+	if (drm_buddy_cache_refill(&mgr->cache, order)) {
+		mutex_unlock(&mgr->lock);
+		return NULL;
+	}
+	mutex_unlock(&mgr->lock);
+
+	return drm_buddy_cache_get(&mgr->cache, order);
+}
+
+static bool amdgpu_vram_mgr_cache_put(struct amdgpu_vram_mgr *mgr,
+				      struct amdgpu_vram_mgr_resource *vres)
+{
+	struct drm_buddy_block *block;
+
+	/* Cleared blocks and pending reservations want the buddy back. */
+	if ((vres->flags & DRM_BUDDY_CLEARED) ||
+	    !list_is_singular(&vres->blocks) ||
+	    !list_empty(&mgr->reservations_pending))
+		return false;
+
+	block = amdgpu_vram_mgr_first_block(&vres->blocks);
+	if (drm_buddy_block_order(block) >= DRM_BUDDY_CACHE_ORDERS)
+		return false;
+
+	if (!drm_buddy_cache_put(&mgr->cache, block)) {
+		mutex_lock(&mgr->lock);
+		drm_buddy_cache_trim(&mgr->cache, drm_buddy_block_order(block));
+		mutex_unlock(&mgr->lock);
+
+		if (!drm_buddy_cache_put(&mgr->cache, block))
+			return false;
+	}
+
+	/*
+	 * A reservation queued after the unlocked check above may already have
+	 * drained the cache. The magazine lock orders the put against that
+	 * drain, so seeing the list still empty here means the drain will
+	 * find our block; otherwise give it back to the buddy ourselves.
+	 */
+	if (unlikely(!list_empty(&mgr->reservations_pending))) {
+		mutex_lock(&mgr->lock);
+		drm_buddy_cache_drain(&mgr->cache);
+		amdgpu_vram_mgr_do_reserve(&mgr->manager);
+		mutex_unlock(&mgr->lock);
+	}
+
+	INIT_LIST_HEAD(&vres->blocks);
+	return true;
+}
+
 /**
  * amdgpu_vram_mgr_new - allocate new ranges
  *
@@ -526,6 +896,13 @@ static int amdgpu_vram_mgr_new(struct ttm_resource_manager *man,
 		vres->flags |= DRM_BUDDY_TRIM_DISABLE;
 	}
 
+	block = amdgpu_vram_mgr_cache_get(mgr, tbo, vres);
+	if (block) {
+		block->private = vres;
+		list_add(&block->link, &vres->blocks);
+		goto allocated;
+	}
+
 	mutex_lock(&mgr->lock);
 	while (remaining_size) {
 		if (tbo->page_alignment)
@@ -559,6 +936,10 @@ static int amdgpu_vram_mgr_new(struct ttm_resource_manager *man,
 			continue;
 		}
 
+		/* Blocks sitting in the per-CPU caches may be all that's left. */
+		if (unlikely(r == -ENOSPC) && drm_buddy_cache_drain(&mgr->cache))
+			continue;
+
 		if (unlikely(r))
 			goto error_free_blocks;
 
@@ -567,6 +948,9 @@ static int amdgpu_vram_mgr_new(struct ttm_resource_manager *man,
 		else
 			remaining_size -= size;
 	}
+
+	list_for_each_entry(block, &vres->blocks, link)
+		block->private = vres;
 	mutex_unlock(&mgr->lock);
 
 	if (bo->flags & AMDGPU_GEM_CREATE_VRAM_CONTIGUOUS && adjust_dcc_size) {
@@ -585,6 +969,7 @@ static int amdgpu_vram_mgr_new(struct ttm_resource_manager *man,
 				     &vres->blocks);
 	}
 
+allocated:
 	vres->base.start = 0;
 	size = max_t(u64, amdgpu_vram_mgr_blocks_size(&vres->blocks),
 		     vres->base.size);
@@ -619,6 +1004,16 @@ static int amdgpu_vram_mgr_new(struct ttm_resource_manager *man,
 error_free_blocks:
 	drm_buddy_free_list(mm, &vres->blocks, 0);
 	mutex_unlock(&mgr->lock);
+
+	/* Free VRAM may just be too fragmented, compact for the next try. */
+	if (r == -ENOSPC && (vres->flags & DRM_BUDDY_CONTIGUOUS_ALLOCATION) &&
+	    time_after_eq(jiffies, READ_ONCE(mgr->compact_next))) {
+		WRITE_ONCE(mgr->compact_next,
+			   jiffies + AMDGPU_VRAM_MGR_COMPACT_INTERVAL);
+		WRITE_ONCE(mgr->compact_order,
+			   ilog2(roundup_pow_of_two(size)) - ilog2(mm->chunk_size));
+		schedule_work(&mgr->compact_work);
+	}
 error_fini:
 	ttm_resource_fini(man, &vres->base);
 	kfree(vres);
@@ -644,15 +1039,23 @@ static void amdgpu_vram_mgr_del(struct ttm_resource_manager *man,
 	struct drm_buddy_block *block;
 	uint64_t vis_usage = 0;
 
-	mutex_lock(&mgr->lock);
 	list_for_each_entry(block, &vres->blocks, link)
 		vis_usage += amdgpu_vram_mgr_vis_size(adev, block);
 
+	if (amdgpu_vram_mgr_cache_put(mgr, vres))
+		goto out;
+
+	mutex_lock(&mgr->lock);
 	amdgpu_vram_mgr_do_reserve(man);
 
 	drm_buddy_free_list(mm, &vres->blocks, vres->flags);
 	mutex_unlock(&mgr->lock);
 
+	if (amdgpu_vram_bg_clear && !(vres->flags & DRM_BUDDY_CLEARED))
+		schedule_delayed_work(&mgr->clear_work,
+				      AMDGPU_VRAM_CLEAR_DELAY);
+
+out:
 	atomic64_sub(vis_usage, &mgr->vis_usage);
 
 	ttm_resource_fini(man, res);
@@ -871,6 +1274,15 @@ static void amdgpu_vram_mgr_debug(struct ttm_resource_manager *man,
 		   mgr->default_page_size >> 10);
 
 	drm_buddy_print(mm, printer);
+	drm_buddy_cache_print(&mgr->cache, printer);
+	drm_printf(printer, "compactions: %lld, moved: %lld, failed: %lld\n",
+		   atomic64_read(&mgr->compactions),
+		   atomic64_read(&mgr->compact_moves),
+		   atomic64_read(&mgr->compact_failed));
+	drm_printf(printer, "clears skipped: %lldMiB, issued: %lldMiB, background: %lldMiB\n",
+		   atomic64_read(&mgr->clear_skipped) >> 20,
+		   atomic64_read(&mgr->clear_issued) >> 20,
+		   atomic64_read(&mgr->bg_cleared) >> 20);
 
 	drm_printf(printer, "reserved:\n");
 	list_for_each_entry(rsv, &mgr->reserved_pages, blocks)
@@ -914,6 +1326,9 @@ int amdgpu_vram_mgr_init(struct amdgpu_device *adev)
 	mutex_init(&mgr->lock);
 	INIT_LIST_HEAD(&mgr->reservations_pending);
 	INIT_LIST_HEAD(&mgr->reserved_pages);
+	INIT_WORK(&mgr->compact_work, amdgpu_vram_mgr_compact_work);
+	mgr->compact_next = jiffies;
+	INIT_DELAYED_WORK(&mgr->clear_work, amdgpu_vram_mgr_clear_work);
 	mgr->default_page_size = PAGE_SIZE;
 
 	if (!adev->gmc.is_app_apu) {
@@ -922,6 +1337,12 @@ int amdgpu_vram_mgr_init(struct amdgpu_device *adev)
 		err = drm_buddy_init(&mgr->mm, man->size, PAGE_SIZE);
 		if (err)
 			return err;
+
+		err = drm_buddy_cache_init(&mgr->cache, &mgr->mm);
+		if (err) {
+			drm_buddy_fini(&mgr->mm);
+			return err;
+		}
 	} else {
 		man->func = &amdgpu_dummy_vram_mgr_func;
 		DRM_INFO("Setup dummy vram mgr\n");
@@ -948,6 +1369,8 @@ void amdgpu_vram_mgr_fini(struct amdgpu_device *adev)
 	struct amdgpu_vram_reservation *rsv, *temp;
 
 	ttm_resource_manager_set_used(man, false);
+	cancel_work_sync(&mgr->compact_work);
+	cancel_delayed_work_sync(&mgr->clear_work);
 
 	ret = ttm_resource_manager_evict_all(&adev->mman.bdev, man);
 	if (ret)
@@ -961,8 +1384,11 @@ void amdgpu_vram_mgr_fini(struct amdgpu_device *adev)
 		drm_buddy_free_list(&mgr->mm, &rsv->allocated, 0);
 		kfree(rsv);
 	}
-	if (!adev->gmc.is_app_apu)
+	if (!adev->gmc.is_app_apu) {
+		drm_buddy_cache_drain(&mgr->cache);
+		drm_buddy_cache_fini(&mgr->cache);
 		drm_buddy_fini(&mgr->mm);
+	}
 	mutex_unlock(&mgr->lock);
 
 	ttm_resource_manager_cleanup(man);
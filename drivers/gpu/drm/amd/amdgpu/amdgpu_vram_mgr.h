@@ -29,12 +29,26 @@
 struct amdgpu_vram_mgr {
 	struct ttm_resource_manager manager;
 	struct drm_buddy mm;
+	/* per-CPU cache of small blocks, refilled under lock */
+	struct drm_buddy_cache cache;
 	/* protects access to buffer objects */
 	struct mutex lock;
 	struct list_head reservations_pending;
 	struct list_head reserved_pages;
 	atomic64_t vis_usage;
 	u64 default_page_size;
+	/* background compaction after failed contiguous allocations */
+	struct work_struct compact_work;
+	unsigned int compact_order;
+	unsigned long compact_next;	/* jiffies, rate limits the work */
+	atomic64_t compactions;
+	atomic64_t compact_moves;
+	atomic64_t compact_failed;
+	/* clearing of freed VRAM while the buffer funcs ring is idle */
+	struct delayed_work clear_work;
+	atomic64_t clear_skipped;	/* bytes found already cleared */
+	atomic64_t clear_issued;	/* bytes cleared on allocation */
+	atomic64_t bg_cleared;		/* bytes cleared in the background */
 };
 
 struct amdgpu_vram_mgr_resource {
@@ -38,13 +38,31 @@ static void drm_block_free(struct drm_buddy *mm,
 	kmem_cache_free(slab_blocks, block);
 }
 
+static struct list_head *
+__free_list(struct drm_buddy *mm, unsigned int order, bool clear)
+{
+	return clear ? &mm->clear_free_list[order] : &mm->free_list[order];
+}
+
+static struct drm_buddy_block *
+last_free_block(struct drm_buddy *mm, unsigned int order, bool clear)
+{
+	struct list_head *head = __free_list(mm, order, clear);
+
+	if (list_empty(head))
+		return NULL;
+
+	return list_last_entry(head, struct drm_buddy_block, link);
+}
+
 static void list_insert_sorted(struct drm_buddy *mm,
 			       struct drm_buddy_block *block)
 {
 	struct drm_buddy_block *node;
 	struct list_head *head;
 
-	head = &mm->free_list[drm_buddy_block_order(block)];
+	head = __free_list(mm, drm_buddy_block_order(block),
+			   drm_buddy_block_is_clear(block));
 	if (list_empty(head)) {
 		list_add(&block->link, head);
 		return;
@@ -167,7 +185,7 @@ static int __force_merge(struct drm_buddy *mm,
 			 unsigned int min_order)
 {
 	unsigned int order;
-	int i;
+	int i, clear;
 
 	if (!min_order)
 		return -ENOMEM;
@@ -176,43 +194,46 @@ static int __force_merge(struct drm_buddy *mm,
 		return -EINVAL;
 
 	for (i = min_order - 1; i >= 0; i--) {
-		struct drm_buddy_block *block, *prev;
+		for (clear = 0; clear < 2; clear++) {
+			struct list_head *head = __free_list(mm, i, clear);
+			struct drm_buddy_block *block, *prev;
 
-		list_for_each_entry_safe_reverse(block, prev, &mm->free_list[i], link) {
-			struct drm_buddy_block *buddy;
-			u64 block_start, block_end;
+			list_for_each_entry_safe_reverse(block, prev, head, link) {
+				struct drm_buddy_block *buddy;
+				u64 block_start, block_end;
 
-			if (!block->parent)
-				continue;
+				if (!block->parent)
+					continue;
 
-			block_start = drm_buddy_block_offset(block);
-			block_end = block_start + drm_buddy_block_size(mm, block) - 1;
+				block_start = drm_buddy_block_offset(block);
+				block_end = block_start + drm_buddy_block_size(mm, block) - 1;
 
-			if (!contains(start, end, block_start, block_end))
-				continue;
+				if (!contains(start, end, block_start, block_end))
+					continue;
 
-			buddy = __get_buddy(block);
-			if (!drm_buddy_block_is_free(buddy))
-				continue;
+				buddy = __get_buddy(block);
+				if (!drm_buddy_block_is_free(buddy))
+					continue;
 
-			WARN_ON(drm_buddy_block_is_clear(block) ==
-				drm_buddy_block_is_clear(buddy));
+				WARN_ON(drm_buddy_block_is_clear(block) ==
+					drm_buddy_block_is_clear(buddy));
 
-			/*
-			 * If the prev block is same as buddy, don't access the
-			 * block in the next iteration as we would free the
-			 * buddy block as part of the free function.
-			 */
-			if (prev == buddy)
-				prev = list_prev_entry(prev, link);
+				/*
+				 * If the prev block is same as buddy, don't access the
+				 * block in the next iteration as we would free the
+				 * buddy block as part of the free function.
+				 */
+				if (prev == buddy)
+					prev = list_prev_entry(prev, link);
 
-			list_del(&block->link);
-			if (drm_buddy_block_is_clear(block))
-				mm->clear_avail -= drm_buddy_block_size(mm, block);
+				list_del(&block->link);
+				if (drm_buddy_block_is_clear(block))
+					mm->clear_avail -= drm_buddy_block_size(mm, block);
 
-			order = __drm_buddy_free(mm, block, true);
-			if (order >= min_order)
-				return 0;
+				order = __drm_buddy_free(mm, block, true);
+				if (order >= min_order)
+					return 0;
+			}
 		}
 	}
 
@@ -261,8 +282,18 @@ int drm_buddy_init(struct drm_buddy *mm, u64 size, u64 chunk_size)
 	if (!mm->free_list)
 		return -ENOMEM;
 
-	for (i = 0; i <= mm->max_order; ++i)
+	mm->clear_free_list = kmalloc_array(mm->max_order + 1,
+					    sizeof(struct list_head),
+					    GFP_KERNEL);
+	if (!mm->clear_free_list) {
+		kfree(mm->free_list);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i <= mm->max_order; ++i) {
 		INIT_LIST_HEAD(&mm->free_list[i]);
+		INIT_LIST_HEAD(&mm->clear_free_list[i]);
+	}
 
 	mm->n_roots = hweight64(size);
 
@@ -310,6 +341,7 @@ out_free_roots:
 		drm_block_free(mm, mm->roots[i]);
 	kfree(mm->roots);
 out_free_list:
+	kfree(mm->clear_free_list);
 	kfree(mm->free_list);
 	return -ENOMEM;
 }
@@ -324,7 +356,7 @@ EXPORT_SYMBOL(drm_buddy_init);
  */
 void drm_buddy_fini(struct drm_buddy *mm)
 {
-	u64 root_size, size;
+	u64 root_size, size, start;
 	unsigned int order;
 	int i;
 
@@ -332,7 +364,8 @@ void drm_buddy_fini(struct drm_buddy *mm)
 
 	for (i = 0; i < mm->n_roots; ++i) {
 		order = ilog2(size) - ilog2(mm->chunk_size);
-		__force_merge(mm, 0, size, order);
+		start = drm_buddy_block_offset(mm->roots[i]);
+		__force_merge(mm, start, start + size, order);
 
 		WARN_ON(!drm_buddy_block_is_free(mm->roots[i]));
 		drm_block_free(mm, mm->roots[i]);
@@ -344,6 +377,7 @@ void drm_buddy_fini(struct drm_buddy *mm)
 	WARN_ON(mm->avail != mm->size);
 
 	kfree(mm->roots);
+	kfree(mm->clear_free_list);
 	kfree(mm->free_list);
 }
 EXPORT_SYMBOL(drm_buddy_fini);
@@ -368,15 +402,16 @@ static int split_block(struct drm_buddy *mm,
 		return -ENOMEM;
 	}
 
-	mark_free(mm, block->left);
-	mark_free(mm, block->right);
-
+	/* The children's clear state decides which free list they go on */
 	if (drm_buddy_block_is_clear(block)) {
 		mark_cleared(block->left);
 		mark_cleared(block->right);
 		clear_reset(block);
 	}
 
+	mark_free(mm, block->left);
+	mark_free(mm, block->right);
+
 	mark_split(block);
 
 	return 0;
@@ -586,20 +621,12 @@ static struct drm_buddy_block *
 get_maxblock(struct drm_buddy *mm, unsigned int order,
 	     unsigned long flags)
 {
-	struct drm_buddy_block *max_block = NULL, *block = NULL;
+	struct drm_buddy_block *max_block = NULL, *block;
+	bool clear = flags & DRM_BUDDY_CLEAR_ALLOCATION;
 	unsigned int i;
 
 	for (i = order; i <= mm->max_order; ++i) {
-		struct drm_buddy_block *tmp_block;
-
-		list_for_each_entry_reverse(tmp_block, &mm->free_list[i], link) {
-			if (block_incompatible(tmp_block, flags))
-				continue;
-
-			block = tmp_block;
-			break;
-		}
-
+		block = last_free_block(mm, i, clear);
 		if (!block)
 			continue;
 
@@ -622,6 +649,7 @@ alloc_from_freelist(struct drm_buddy *mm,
 		    unsigned int order,
 		    unsigned long flags)
 {
+	bool clear = flags & DRM_BUDDY_CLEAR_ALLOCATION;
 	struct drm_buddy_block *block = NULL;
 	unsigned int tmp;
 	int err;
@@ -633,31 +661,18 @@ alloc_from_freelist(struct drm_buddy *mm,
 			tmp = drm_buddy_block_order(block);
 	} else {
 		for (tmp = order; tmp <= mm->max_order; ++tmp) {
-			struct drm_buddy_block *tmp_block;
-
-			list_for_each_entry_reverse(tmp_block, &mm->free_list[tmp], link) {
-				if (block_incompatible(tmp_block, flags))
-					continue;
-
-				block = tmp_block;
-				break;
-			}
-
+			block = last_free_block(mm, tmp, clear);
 			if (block)
 				break;
 		}
 	}
 
 	if (!block) {
-		/* Fallback method */
+		/* Fallback method, nothing of the requested clear state */
 		for (tmp = order; tmp <= mm->max_order; ++tmp) {
-			if (!list_empty(&mm->free_list[tmp])) {
-				block = list_last_entry(&mm->free_list[tmp],
-							struct drm_buddy_block,
-							link);
-				if (block)
-					break;
-			}
+			block = last_free_block(mm, tmp, !clear);
+			if (block)
+				break;
 		}
 
 		if (!block)
@@ -805,6 +820,7 @@ static int __alloc_contig_try_harder(struct drm_buddy *mm,
 	unsigned long pages;
 	unsigned int order;
 	u64 modify_size;
+	int clear;
 	int err;
 
 	modify_size = rounddown_pow_of_two(size);
@@ -813,35 +829,35 @@ static int __alloc_contig_try_harder(struct drm_buddy *mm,
 	if (order == 0)
 		return -ENOSPC;
 
-	list = &mm->free_list[order];
-	if (list_empty(list))
-		return -ENOSPC;
-
-	list_for_each_entry_reverse(block, list, link) {
-		/* Allocate blocks traversing RHS */
-		rhs_offset = drm_buddy_block_offset(block);
-		err =  __drm_buddy_alloc_range(mm, rhs_offset, size,
-					       &filled, blocks);
-		if (!err || err != -ENOSPC)
-			return err;
-
-		lhs_size = max((size - filled), min_block_size);
-		if (!IS_ALIGNED(lhs_size, min_block_size))
-			lhs_size = round_up(lhs_size, min_block_size);
-
-		/* Allocate blocks traversing LHS */
-		lhs_offset = drm_buddy_block_offset(block) - lhs_size;
-		err =  __drm_buddy_alloc_range(mm, lhs_offset, lhs_size,
-					       NULL, &blocks_lhs);
-		if (!err) {
-			list_splice(&blocks_lhs, blocks);
-			return 0;
-		} else if (err != -ENOSPC) {
+	for (clear = 0; clear < 2; clear++) {
+		list = __free_list(mm, order, clear);
+
+		list_for_each_entry_reverse(block, list, link) {
+			/* Allocate blocks traversing RHS */
+			rhs_offset = drm_buddy_block_offset(block);
+			err =  __drm_buddy_alloc_range(mm, rhs_offset, size,
+						       &filled, blocks);
+			if (!err || err != -ENOSPC)
+				return err;
+
+			lhs_size = max((size - filled), min_block_size);
+			if (!IS_ALIGNED(lhs_size, min_block_size))
+				lhs_size = round_up(lhs_size, min_block_size);
+
+			/* Allocate blocks traversing LHS */
+			lhs_offset = drm_buddy_block_offset(block) - lhs_size;
+			err =  __drm_buddy_alloc_range(mm, lhs_offset, lhs_size,
+						       NULL, &blocks_lhs);
+			if (!err) {
+				list_splice(&blocks_lhs, blocks);
+				return 0;
+			} else if (err != -ENOSPC) {
+				drm_buddy_free_list_internal(mm, blocks);
+				return err;
+			}
+			/* Free blocks for the next iteration */
 			drm_buddy_free_list_internal(mm, blocks);
-			return err;
 		}
-		/* Free blocks for the next iteration */
-		drm_buddy_free_list_internal(mm, blocks);
 	}
 
 	return -ENOSPC;
@@ -1120,6 +1136,510 @@ err_free:
 }
 EXPORT_SYMBOL(drm_buddy_alloc_blocks);
 
+static struct drm_buddy_magazine *
+drm_buddy_cache_mag(struct drm_buddy_cache *cache)
+{
+	return &cache->mags[smp_processor_id() % cache->nr_mags];
+}
+
+/**
+ * drm_buddy_cache_init - init per-CPU caches of small blocks
+ *
+ * @cache: the cache to initialize
+ * @mm: DRM buddy manager the blocks are allocated from
+ *
+ * Returns:
+ * 0 on success, error code on failure.
+ */
+int drm_buddy_cache_init(struct drm_buddy_cache *cache, struct drm_buddy *mm)
+{
+	unsigned int i;
+
+	cache->nr_mags = nr_cpu_ids;
+	cache->mags = kcalloc(cache->nr_mags, sizeof(*cache->mags), GFP_KERNEL);
+	if (!cache->mags)
+		return -ENOMEM;
+
+	for (i = 0; i < cache->nr_mags; i++)
+		spin_lock_init(&cache->mags[i].lock);
+
+	cache->mm = mm;
+	atomic64_set(&cache->hits, 0);
+	atomic64_set(&cache->refills, 0);
+	atomic64_set(&cache->frees, 0);
+	atomic64_set(&cache->trims, 0);
+
+	return 0;
+}
+EXPORT_SYMBOL(drm_buddy_cache_init);
+
+/**
+ * drm_buddy_cache_fini - tear down per-CPU caches
+ *
+ * @cache: the cache to tear down
+ *
+ * The cache must have been emptied with drm_buddy_cache_drain() first.
+ */
+void drm_buddy_cache_fini(struct drm_buddy_cache *cache)
+{
+	unsigned int i, order;
+
+	for (i = 0; i < cache->nr_mags; i++)
+		for (order = 0; order < DRM_BUDDY_CACHE_ORDERS; order++)
+			WARN_ON(cache->mags[i].count[order]);
+
+	kfree(cache->mags);
+	cache->mags = NULL;
+}
+EXPORT_SYMBOL(drm_buddy_cache_fini);
+
+/**
+ * drm_buddy_cache_get - take a block from the current CPU's cache
+ *
+ * @cache: the cache
+ * @order: block order, relative to the chunk size
+ *
+ * Does not need the buddy lock.
+ *
+ * Returns:
+ * An allocated block of @order, or NULL if the cache is empty.
+ */
+struct drm_buddy_block *
+drm_buddy_cache_get(struct drm_buddy_cache *cache, unsigned int order)
+{
+	struct drm_buddy_magazine *mag;
+	struct drm_buddy_block *block = NULL;
+
+	if (order >= DRM_BUDDY_CACHE_ORDERS)
+		return NULL;
+
+	mag = drm_buddy_cache_mag(cache);
+	spin_lock(&mag->lock);
+	if (!cache->disabled && mag->count[order])
+		block = mag->blocks[order][--mag->count[order]];
+	spin_unlock(&mag->lock);
+
+	if (block)
+		atomic64_inc(&cache->hits);
+
+	return block;
+}
+EXPORT_SYMBOL(drm_buddy_cache_get);
+
+/**
+ * drm_buddy_cache_put - give a block back to the current CPU's cache
+ *
+ * @cache: the cache
+ * @block: allocated block to free
+ *
+ * Does not need the buddy lock. The block is considered dirty from now on.
+ *
+ * Returns:
+ * True if the block was cached, false if its order isn't cached or the
+ * cache is full and the block must be freed to the buddy instead.
+ */
+bool drm_buddy_cache_put(struct drm_buddy_cache *cache,
+			 struct drm_buddy_block *block)
+{
+	unsigned int order = drm_buddy_block_order(block);
+	struct drm_buddy_magazine *mag;
+	bool cached = false;
+
+	if (order >= DRM_BUDDY_CACHE_ORDERS)
+		return false;
+
+	mag = drm_buddy_cache_mag(cache);
+	spin_lock(&mag->lock);
+	if (!cache->disabled && mag->count[order] < DRM_BUDDY_CACHE_SIZE) {
+		clear_reset(block);
+		block->private = NULL;
+		mag->blocks[order][mag->count[order]++] = block;
+		cached = true;
+	}
+	spin_unlock(&mag->lock);
+
+	if (cached)
+		atomic64_inc(&cache->frees);
+
+	return cached;
+}
+EXPORT_SYMBOL(drm_buddy_cache_put);
+
+/**
+ * drm_buddy_cache_refill - refill the current CPU's cache
+ *
+ * @cache: the cache
+ * @order: block order to refill
+ *
+ * Allocates a batch of blocks of @order from the buddy. Must be called with
+ * the buddy lock held.
+ *
+ * Returns:
+ * 0 if at least one block was cached, error code otherwise.
+ */
+int drm_buddy_cache_refill(struct drm_buddy_cache *cache, unsigned int order)
+{
+	struct drm_buddy *mm = cache->mm;
+	u64 size = mm->chunk_size << order;
+	struct drm_buddy_block *block, *on;
+	struct drm_buddy_magazine *mag;
+	LIST_HEAD(blocks);
+	unsigned int i;
+	int err = 0;
+
+	if (order >= DRM_BUDDY_CACHE_ORDERS || order > mm->max_order)
+		return -EINVAL;
+
+	if (cache->disabled)
+		return -EBUSY;
+
+	for (i = 0; i < DRM_BUDDY_CACHE_BATCH; i++) {
+		err = drm_buddy_alloc_blocks(mm, 0, mm->size, size, size,
+					     &blocks, 0);
+		if (err)
+			break;
+	}
+	if (list_empty(&blocks))
+		return err;
+
+	mag = drm_buddy_cache_mag(cache);
+	spin_lock(&mag->lock);
+	list_for_each_entry_safe(block, on, &blocks, link) {
+		if (mag->count[order] == DRM_BUDDY_CACHE_SIZE)
+			break;
+		list_del(&block->link);
+		block->private = NULL;
+		mag->blocks[order][mag->count[order]++] = block;
+	}
+	spin_unlock(&mag->lock);
+
+	/* Frees on this CPU may have filled the cache meanwhile. */
+	drm_buddy_free_list_internal(mm, &blocks);
+	atomic64_inc(&cache->refills);
+
+	return 0;
+}
+EXPORT_SYMBOL(drm_buddy_cache_refill);
+
+/**
+ * drm_buddy_cache_trim - trim the current CPU's cache
+ *
+ * @cache: the cache
+ * @order: block order to trim
+ *
+ * Returns blocks to the buddy until only a batch is left, for when the cache
+ * keeps overflowing. Blocks whose buddy is free go first, as they merge
+ * right away instead of leaving holes behind. Must be called with the buddy
+ * lock held.
+ */
+void drm_buddy_cache_trim(struct drm_buddy_cache *cache, unsigned int order)
+{
+	struct drm_buddy_block *block, *buddy;
+	struct drm_buddy_magazine *mag;
+	unsigned int i, n, count;
+	LIST_HEAD(blocks);
+
+	if (order >= DRM_BUDDY_CACHE_ORDERS)
+		return;
+
+	mag = drm_buddy_cache_mag(cache);
+	spin_lock(&mag->lock);
+	count = mag->count[order];
+	for (i = 0, n = 0; i < mag->count[order]; i++) {
+		block = mag->blocks[order][i];
+		buddy = drm_get_buddy(block);
+		if (count > DRM_BUDDY_CACHE_BATCH &&
+		    buddy && drm_buddy_block_is_free(buddy)) {
+			list_add_tail(&block->link, &blocks);
+			count--;
+		} else {
+			mag->blocks[order][n++] = block;
+		}
+	}
+
+	/* Then the least recently freed ones at the bottom of the stack. */
+	count = n > DRM_BUDDY_CACHE_BATCH ? n - DRM_BUDDY_CACHE_BATCH : 0;
+	for (i = 0; i < count; i++)
+		list_add_tail(&mag->blocks[order][i]->link, &blocks);
+	memmove(&mag->blocks[order][0], &mag->blocks[order][count],
+		(n - count) * sizeof(mag->blocks[order][0]));
+	mag->count[order] = n - count;
+	spin_unlock(&mag->lock);
+
+	drm_buddy_free_list(cache->mm, &blocks, 0);
+	atomic64_inc(&cache->trims);
+}
+EXPORT_SYMBOL(drm_buddy_cache_trim);
+
+/**
+ * drm_buddy_cache_drain - return all cached blocks to the buddy
+ *
+ * @cache: the cache
+ *
+ * Used when the buddy runs out of space and before teardown. Must be called
+ * with the buddy lock held.
+ *
+ * Returns:
+ * True if any block was returned.
+ */
+bool drm_buddy_cache_drain(struct drm_buddy_cache *cache)
+{
+	struct drm_buddy_magazine *mag;
+	unsigned int i, j, order;
+	LIST_HEAD(blocks);
+
+	for (i = 0; i < cache->nr_mags; i++) {
+		mag = &cache->mags[i];
+		spin_lock(&mag->lock);
+		for (order = 0; order < DRM_BUDDY_CACHE_ORDERS; order++) {
+			for (j = 0; j < mag->count[order]; j++)
+				list_add_tail(&mag->blocks[order][j]->link,
+					      &blocks);
+			mag->count[order] = 0;
+		}
+		spin_unlock(&mag->lock);
+	}
+
+	if (list_empty(&blocks))
+		return false;
+
+	drm_buddy_free_list(cache->mm, &blocks, 0);
+	return true;
+}
+EXPORT_SYMBOL(drm_buddy_cache_drain);
+
+/**
+ * drm_buddy_cache_disable - drain the cache and keep it empty
+ *
+ * @cache: the cache
+ *
+ * Once this returns, every allocated block is owned by a user of the buddy
+ * again and drm_buddy_cache_put() fails until drm_buddy_cache_enable(). Must
+ * be called with the buddy lock held.
+ */
+void drm_buddy_cache_disable(struct drm_buddy_cache *cache)
+{
+	unsigned int i;
+
+	WRITE_ONCE(cache->disabled, true);
+
+	/* Wait for puts that saw the cache enabled. */
+	for (i = 0; i < cache->nr_mags; i++) {
+		spin_lock(&cache->mags[i].lock);
+		spin_unlock(&cache->mags[i].lock);
+	}
+
+	drm_buddy_cache_drain(cache);
+}
+EXPORT_SYMBOL(drm_buddy_cache_disable);
+
+/**
+ * drm_buddy_cache_enable - re-enable a disabled cache
+ *
+ * @cache: the cache
+ */
+void drm_buddy_cache_enable(struct drm_buddy_cache *cache)
+{
+	WRITE_ONCE(cache->disabled, false);
+}
+EXPORT_SYMBOL(drm_buddy_cache_enable);
+
+/**
+ * drm_buddy_cache_print - print cache statistics
+ *
+ * @cache: the cache
+ * @p: DRM printer to use
+ */
+void drm_buddy_cache_print(struct drm_buddy_cache *cache,
+			   struct drm_printer *p)
+{
+	u64 cached = 0;
+	unsigned int i, order;
+
+	for (i = 0; i < cache->nr_mags; i++)
+		for (order = 0; order < DRM_BUDDY_CACHE_ORDERS; order++)
+			cached += (u64)READ_ONCE(cache->mags[i].count[order]) *
+				  (cache->mm->chunk_size << order);
+
+	drm_printf(p, "cache: %lluKiB, hits: %lld, frees: %lld, refills: %lld, trims: %lld\n",
+		   cached >> 10, atomic64_read(&cache->hits),
+		   atomic64_read(&cache->frees),
+		   atomic64_read(&cache->refills),
+		   atomic64_read(&cache->trims));
+}
+EXPORT_SYMBOL(drm_buddy_cache_print);
+
+/**
+ * drm_buddy_fragmentation - fragmentation index for an allocation order
+ *
+ * @mm: DRM buddy manager
+ * @order: allocation order, relative to the chunk size
+ *
+ * Returns:
+ * The share of free memory, in thousandths, that sits in blocks too small
+ * for an allocation of @order. 0 means all free memory can serve it, 1000
+ * that none can.
+ */
+unsigned int drm_buddy_fragmentation(struct drm_buddy *mm, unsigned int order)
+{
+	struct drm_buddy_block *block;
+	u64 usable = 0;
+	unsigned int i;
+
+	if (!mm->avail)
+		return 0;
+
+	for (i = order; i <= mm->max_order; i++) {
+		list_for_each_entry(block, &mm->free_list[i], link)
+			usable += drm_buddy_block_size(mm, block);
+		list_for_each_entry(block, &mm->clear_free_list[i], link)
+			usable += drm_buddy_block_size(mm, block);
+	}
+
+	return div64_u64((mm->avail - usable) * 1000, mm->avail);
+}
+EXPORT_SYMBOL(drm_buddy_fragmentation);
+
+/*
+ * Sum up the allocated memory below @root, or return U64_MAX if any of it
+ * can't be moved.
+ */
+static u64 compact_cost(struct drm_buddy *mm, struct drm_buddy_block *root,
+			bool (*movable)(struct drm_buddy_block *block, void *arg),
+			void *arg)
+{
+	struct drm_buddy_block *block;
+	LIST_HEAD(dfs);
+	u64 cost = 0;
+
+	list_add(&root->tmp_link, &dfs);
+	while ((block = list_first_entry_or_null(&dfs,
+						 struct drm_buddy_block,
+						 tmp_link))) {
+		list_del(&block->tmp_link);
+
+		if (drm_buddy_block_is_split(block)) {
+			list_add(&block->right->tmp_link, &dfs);
+			list_add(&block->left->tmp_link, &dfs);
+		} else if (drm_buddy_block_is_allocated(block)) {
+			if (!movable(block, arg)) {
+				cost = U64_MAX;
+				break;
+			}
+			cost += drm_buddy_block_size(mm, block);
+		}
+	}
+
+	return cost;
+}
+
+/**
+ * drm_buddy_compact_target - pick a range to compact
+ *
+ * @mm: DRM buddy manager
+ * @order: order of the allocation that failed
+ * @movable: tells whether an allocated block can be migrated
+ * @arg: passed to @movable
+ * @start: returns the start of the range
+ *
+ * Of all naturally aligned ranges of @order that are split, picks the one
+ * with the least allocated memory, all of which must be @movable. Moving
+ * those allocations elsewhere lets the range merge back into one free
+ * block. Must be called with the buddy lock held.
+ *
+ * Returns:
+ * 0 on success, -ENOSPC if there's no such range.
+ */
+int drm_buddy_compact_target(struct drm_buddy *mm, unsigned int order,
+			     bool (*movable)(struct drm_buddy_block *block,
+					     void *arg),
+			     void *arg, u64 *start)
+{
+	struct drm_buddy_block *block, *best = NULL;
+	u64 cost, best_cost = U64_MAX;
+	LIST_HEAD(dfs);
+	unsigned int i;
+
+	for (i = 0; i < mm->n_roots; i++)
+		list_add_tail(&mm->roots[i]->tmp_link, &dfs);
+
+	while ((block = list_first_entry_or_null(&dfs,
+						 struct drm_buddy_block,
+						 tmp_link))) {
+		list_del(&block->tmp_link);
+
+		if (!drm_buddy_block_is_split(block) ||
+		    drm_buddy_block_order(block) < order)
+			continue;
+
+		if (drm_buddy_block_order(block) > order) {
+			list_add(&block->right->tmp_link, &dfs);
+			list_add(&block->left->tmp_link, &dfs);
+			continue;
+		}
+
+		/* Free but unmerged ranges are left to __force_merge(). */
+		cost = compact_cost(mm, block, movable, arg);
+		if (cost && cost < best_cost) {
+			best = block;
+			best_cost = cost;
+		}
+	}
+
+	if (!best)
+		return -ENOSPC;
+
+	*start = drm_buddy_block_offset(best);
+	return 0;
+}
+EXPORT_SYMBOL(drm_buddy_compact_target);
+
+/**
+ * drm_buddy_for_each_allocated - visit the allocated blocks in a range
+ *
+ * @mm: DRM buddy manager
+ * @start: start of the range
+ * @end: end of the range
+ * @fn: called for each allocated block overlapping the range
+ * @arg: passed to @fn
+ *
+ * Must be called with the buddy lock held, @fn must not modify the buddy.
+ */
+void drm_buddy_for_each_allocated(struct drm_buddy *mm, u64 start, u64 end,
+				  void (*fn)(struct drm_buddy_block *block,
+					     void *arg),
+				  void *arg)
+{
+	struct drm_buddy_block *block;
+	u64 block_start, block_end;
+	LIST_HEAD(dfs);
+	unsigned int i;
+
+	end = end - 1;
+
+	for (i = 0; i < mm->n_roots; i++)
+		list_add_tail(&mm->roots[i]->tmp_link, &dfs);
+
+	while ((block = list_first_entry_or_null(&dfs,
+						 struct drm_buddy_block,
+						 tmp_link))) {
+		list_del(&block->tmp_link);
+
+		block_start = drm_buddy_block_offset(block);
+		block_end = block_start + drm_buddy_block_size(mm, block) - 1;
+		if (!overlaps(start, end, block_start, block_end))
+			continue;
+
+		if (drm_buddy_block_is_split(block)) {
+			list_add(&block->right->tmp_link, &dfs);
+			list_add(&block->left->tmp_link, &dfs);
+		} else if (drm_buddy_block_is_allocated(block)) {
+			fn(block, arg);
+		}
+	}
+}
+EXPORT_SYMBOL(drm_buddy_for_each_allocated);
+
 /**
  * drm_buddy_block_print - print block information
  *
@@ -1160,6 +1680,12 @@ void drm_buddy_print(struct drm_buddy *mm, struct drm_printer *p)
 			count++;
 		}
 
+		list_for_each_entry(block, &mm->clear_free_list[order], link) {
+			BUG_ON(!drm_buddy_block_is_free(block));
+			BUG_ON(!drm_buddy_block_is_clear(block));
+			count++;
+		}
+
 		drm_printf(p, "order-%2d ", order);
 
 		free = count * (mm->chunk_size << order);
@@ -1,8 +1,10 @@
 // SPDX-License-Identifier: GPL-2.0 OR MIT
 
+#include <drm/drm_device.h>
 #include <drm/drm_exec.h>
 #include <drm/drm_gem.h>
 #include <linux/dma-resv.h>
+#include <linux/sort.h>
 
 /**
  * DOC: Overview
@@ -44,6 +46,17 @@
  *	}
  *	drm_exec_fini(&exec);
  *
+ * When the full set of objects is known up front, e.g. the buffer list of a
+ * command submission, drm_exec_prepare_array_sorted() locks them in a global
+ * order. Submitters sharing objects then contend at most once per conflicting
+ * context instead of repeatedly backing off each other, which matters with
+ * hundreds of objects per submission. Together with drm_exec_init_array() and
+ * caller provided storage for the locked objects the locking loop does not
+ * allocate memory at all.
+ *
+ * Restarts and the time spent in them are accounted to the device of the
+ * contended object and reported by the hw.dri.N.exec sysctl.
+ *
  * See struct dma_exec for more details.
  */
 
@@ -65,6 +78,35 @@ static void drm_exec_unlock_all(struct drm_exec *exec)
 	exec->prelocked = NULL;
 }
 
+/* Account the restarts of this context to the device statistics */
+static void drm_exec_account_restarts(struct drm_exec *exec)
+{
+#ifdef __FreeBSD__
+	struct drm_device *dev = exec->contended_dev;
+
+	if (likely(!exec->restarts))
+		return;
+
+	atomic64_inc(&dev->exec_stats.contended);
+	atomic64_add(exec->restarts, &dev->exec_stats.restarts);
+	atomic64_add(ktime_to_ns(ktime_sub(ktime_get(),
+					   exec->contended_start)),
+		     &dev->exec_stats.restart_ns);
+#endif
+	exec->restarts = 0;
+}
+
+static void __drm_exec_init(struct drm_exec *exec, u32 flags)
+{
+	exec->flags = flags;
+	exec->num_objects = 0;
+	exec->contended = DRM_EXEC_DUMMY;
+	exec->prelocked = NULL;
+	exec->objects_prealloc = false;
+	exec->restarts = 0;
+	exec->contended_dev = NULL;
+}
+
 /**
  * drm_exec_init - initialize a drm_exec object
  * @exec: the drm_exec object to initialize
@@ -81,17 +123,36 @@ void drm_exec_init(struct drm_exec *exec, u32 flags, unsigned nr)
 	if (!nr)
 		nr = PAGE_SIZE / sizeof(void *);
 
-	exec->flags = flags;
+	__drm_exec_init(exec, flags);
 	exec->objects = kvmalloc_array(nr, sizeof(void *), GFP_KERNEL);
 
 	/* If allocation here fails, just delay that till the first use */
 	exec->max_objects = exec->objects ? nr : 0;
-	exec->num_objects = 0;
-	exec->contended = DRM_EXEC_DUMMY;
-	exec->prelocked = NULL;
 }
 EXPORT_SYMBOL(drm_exec_init);
 
+/**
+ * drm_exec_init_array - initialize a drm_exec object with caller storage
+ * @exec: the drm_exec object to initialize
+ * @flags: controls locking behavior, see DRM_EXEC_* defines
+ * @objects: storage for @nr locked object pointers
+ * @nr: the size of @objects
+ *
+ * Like drm_exec_init(), but tracks the locked objects in @objects, e.g. an
+ * array embedded in the submission job, instead of allocating a table. The
+ * storage must stay valid until drm_exec_fini(). Should more than @nr objects
+ * get locked, the table is moved to an allocated one.
+ */
+void drm_exec_init_array(struct drm_exec *exec, u32 flags,
+			 struct drm_gem_object **objects, unsigned int nr)
+{
+	__drm_exec_init(exec, flags);
+	exec->objects = objects;
+	exec->max_objects = nr;
+	exec->objects_prealloc = true;
+}
+EXPORT_SYMBOL(drm_exec_init_array);
+
 /**
  * drm_exec_fini - finalize a drm_exec object
  * @exec: the drm_exec object to finalize
@@ -101,8 +162,10 @@ EXPORT_SYMBOL(drm_exec_init);
  */
 void drm_exec_fini(struct drm_exec *exec)
 {
+	drm_exec_account_restarts(exec);
 	drm_exec_unlock_all(exec);
-	kvfree(exec->objects);
+	if (!exec->objects_prealloc)
+		kvfree(exec->objects);
 	if (exec->contended != DRM_EXEC_DUMMY) {
 		drm_gem_object_put(exec->contended);
 		ww_acquire_fini(&exec->ticket);
@@ -122,6 +185,7 @@ bool drm_exec_cleanup(struct drm_exec *exec)
 {
 	if (likely(!exec->contended)) {
 		ww_acquire_done(&exec->ticket);
+		drm_exec_account_restarts(exec);
 		return false;
 	}
 
@@ -131,6 +195,11 @@ bool drm_exec_cleanup(struct drm_exec *exec)
 		return true;
 	}
 
+	if (!exec->restarts++) {
+		exec->contended_start = ktime_get();
+		exec->contended_dev = exec->contended->dev;
+	}
+
 	drm_exec_unlock_all(exec);
 	exec->num_objects = 0;
 	return true;
@@ -142,16 +211,28 @@ static int drm_exec_obj_locked(struct drm_exec *exec,
 			       struct drm_gem_object *obj)
 {
 	if (unlikely(exec->num_objects == exec->max_objects)) {
+		unsigned int nr = max_t(unsigned int, exec->max_objects * 2,
+					PAGE_SIZE / sizeof(void *));
 		size_t size = exec->max_objects * sizeof(void *);
 		void *tmp;
 
-		tmp = kvrealloc(exec->objects, size, size + PAGE_SIZE,
-				GFP_KERNEL);
-		if (!tmp)
-			return -ENOMEM;
+		/* Grow geometrically, submissions can lock thousands of BOs */
+		if (exec->objects_prealloc) {
+			tmp = kvmalloc_array(nr, sizeof(void *), GFP_KERNEL);
+			if (!tmp)
+				return -ENOMEM;
+
+			memcpy(tmp, exec->objects, size);
+			exec->objects_prealloc = false;
+		} else {
+			tmp = kvrealloc(exec->objects, size,
+					nr * sizeof(void *), GFP_KERNEL);
+			if (!tmp)
+				return -ENOMEM;
+		}
 
 		exec->objects = tmp;
-		exec->max_objects += PAGE_SIZE / sizeof(void *);
+		exec->max_objects = nr;
 	}
 	drm_gem_object_get(obj);
 	exec->objects[exec->num_objects++] = obj;
@@ -336,5 +417,56 @@ int drm_exec_prepare_array(struct drm_exec *exec,
 }
 EXPORT_SYMBOL(drm_exec_prepare_array);
 
+static int drm_exec_cmp_resv(const void *a, const void *b)
+{
+	const struct drm_gem_object *obj_a = *(struct drm_gem_object **)a;
+	const struct drm_gem_object *obj_b = *(struct drm_gem_object **)b;
+
+	if (obj_a->resv != obj_b->resv)
+		return obj_a->resv < obj_b->resv ? -1 : 1;
+
+	if (obj_a != obj_b)
+		return obj_a < obj_b ? -1 : 1;
+
+	return 0;
+}
+
+/**
+ * drm_exec_prepare_array_sorted - prepare an array of objects in global order
+ * @exec: the drm_exec object with the state
+ * @objects: array of GEM object to prepare, reordered by this function
+ * @num_objects: number of GEM objects in the array
+ * @num_fences: number of fences to reserve on each GEM object
+ *
+ * Like drm_exec_prepare_array(), but sorts @objects by their reservation
+ * object first, so that all contexts using this function lock shared objects
+ * in the same order and don't keep backing off each other. Duplicate entries
+ * in @objects are skipped.
+ *
+ * Returns: -EDEADLOCK on contention, -EALREADY when object is already locked,
+ * -ENOMEM when memory allocation failed and zero for success.
+ */
+int drm_exec_prepare_array_sorted(struct drm_exec *exec,
+				  struct drm_gem_object **objects,
+				  unsigned int num_objects,
+				  unsigned int num_fences)
+{
+	int ret;
+
+	sort(objects, num_objects, sizeof(*objects), drm_exec_cmp_resv, NULL);
+
+	for (unsigned int i = 0; i < num_objects; ++i) {
+		if (i && objects[i] == objects[i - 1])
+			continue;
+
+		ret = drm_exec_prepare_obj(exec, objects[i], num_fences);
+		if (unlikely(ret))
+			return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(drm_exec_prepare_array_sorted);
+
 MODULE_DESCRIPTION("DRM execution context");
 MODULE_LICENSE("Dual MIT/GPL");
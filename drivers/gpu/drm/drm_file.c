@@ -48,6 +48,29 @@
 #include "drm_crtc_internal.h"
 #include "drm_internal.h"
 
+#ifdef __FreeBSD__
+#include <sys/counter.h>
+#include <sys/sysctl.h>
+
+SYSCTL_DECL(_hw_dri);
+static COUNTER_U64_DEFINE_EARLY(drm_events_sent);
+SYSCTL_COUNTER_U64(_hw_dri, OID_AUTO, events_sent, CTLFLAG_RD,
+    &drm_events_sent, "Events queued for delivery to userspace");
+static COUNTER_U64_DEFINE_EARLY(drm_events_wakeups);
+SYSCTL_COUNTER_U64(_hw_dri, OID_AUTO, events_wakeups, CTLFLAG_RD,
+    &drm_events_wakeups, "Wakeups of readers waiting for events");
+static COUNTER_U64_DEFINE_EARLY(drm_events_read);
+SYSCTL_COUNTER_U64(_hw_dri, OID_AUTO, events_read, CTLFLAG_RD,
+    &drm_events_read, "Events copied out by drm_read()");
+static COUNTER_U64_DEFINE_EARLY(drm_events_copyouts);
+SYSCTL_COUNTER_U64(_hw_dri, OID_AUTO, events_copyouts, CTLFLAG_RD,
+    &drm_events_copyouts, "Copyouts done by drm_read()");
+
+#define	drm_event_stat(name, n)	counter_u64_add(drm_events_##name, n)
+#else
+#define	drm_event_stat(name, n)	do { } while (0)
+#endif
+
 /* from BKL pushdown */
 DEFINE_MUTEX(drm_global_mutex);
 
@@ -166,6 +189,7 @@ struct drm_file *drm_file_alloc(struct drm_minor *minor)
 	INIT_LIST_HEAD(&file->blobs);
 	INIT_LIST_HEAD(&file->pending_event_list);
 	INIT_LIST_HEAD(&file->event_list);
+	INIT_LIST_HEAD(&file->event_wake_link);
 	init_waitqueue_head(&file->event_wait);
 	file->event_space = 4096; /* set aside 4k for event buffer */
 
@@ -576,6 +600,7 @@ ssize_t drm_read(struct file *filp, char __user *buffer,
 {
 	struct drm_file *file_priv = filp->private_data;
 	struct drm_device *dev = file_priv->minor->dev;
+	char stack_buf[256];
 	ssize_t ret;
 
 	ret = mutex_lock_interruptible(&file_priv->event_read_lock);
@@ -583,18 +608,30 @@ ssize_t drm_read(struct file *filp, char __user *buffer,
 		return ret;
 
 	for (;;) {
-		struct drm_pending_event *e = NULL;
+		struct drm_pending_event *e, *t;
+		unsigned int nevents = 0;
+		size_t length = 0;
+		LIST_HEAD(events);
+		char *buf;
 
+		/* Take everything that fits, so it can go out in one copy. */
 		spin_lock_irq(&dev->event_lock);
-		if (!list_empty(&file_priv->event_list)) {
-			e = list_first_entry(&file_priv->event_list,
-					struct drm_pending_event, link);
-			file_priv->event_space += e->event->length;
-			list_del(&e->link);
+		list_for_each_entry_safe(e, t, &file_priv->event_list, link) {
+			if (e->event->length > count - ret - length)
+				break;
+			length += e->event->length;
+			list_move_tail(&e->link, &events);
+			nevents++;
+		}
+		file_priv->event_space += length;
+		if (!nevents && !list_empty(&file_priv->event_list)) {
+			/* The next event doesn't fit into what is left. */
+			spin_unlock_irq(&dev->event_lock);
+			break;
 		}
 		spin_unlock_irq(&dev->event_lock);
 
-		if (e == NULL) {
+		if (!nevents) {
 			if (ret)
 				break;
 
@@ -610,33 +647,47 @@ ssize_t drm_read(struct file *filp, char __user *buffer,
 				ret = mutex_lock_interruptible(&file_priv->event_read_lock);
 			if (ret)
 				return ret;
-		} else {
-			unsigned length = e->event->length;
-
-			if (length > count - ret) {
-put_back_event:
-				spin_lock_irq(&dev->event_lock);
-				file_priv->event_space -= length;
-				list_add(&e->link, &file_priv->event_list);
-				spin_unlock_irq(&dev->event_lock);
+			continue;
+		}
+
+		buf = stack_buf;
+		if (length > sizeof(stack_buf))
+			buf = kmalloc(length, GFP_KERNEL);
+
+		if (buf) {
+			length = 0;
+			list_for_each_entry(e, &events, link) {
+				memcpy(buf + length, e->event, e->event->length);
+				length += e->event->length;
+			}
+			drm_event_stat(copyouts, 1);
+		}
+
+		if (!buf || copy_to_user(buffer + ret, buf, length)) {
+			if (buf != stack_buf)
+				kfree(buf);
+			if (ret == 0)
+				ret = buf ? -EFAULT : -ENOMEM;
+
+			spin_lock_irq(&dev->event_lock);
+			file_priv->event_space -= length;
+			list_splice(&events, &file_priv->event_list);
+			spin_unlock_irq(&dev->event_lock);
 #ifdef __linux__
-				wake_up_interruptible_poll(&file_priv->event_wait,
-					EPOLLIN | EPOLLRDNORM);
+			wake_up_interruptible_poll(&file_priv->event_wait,
+				EPOLLIN | EPOLLRDNORM);
 #elif defined(__FreeBSD__)
-				wake_up_interruptible(&file_priv->event_wait);
+			wake_up_interruptible(&file_priv->event_wait);
 #endif
-				break;
-			}
-
-			if (copy_to_user(buffer + ret, e->event, length)) {
-				if (ret == 0)
-					ret = -EFAULT;
-				goto put_back_event;
-			}
+			break;
+		}
 
-			ret += length;
+		if (buf != stack_buf)
+			kfree(buf);
+		drm_event_stat(read, nevents);
+		ret += length;
+		list_for_each_entry_safe(e, t, &events, link)
 			kfree(e);
-		}
 	}
 	mutex_unlock(&file_priv->event_read_lock);
 
@@ -785,7 +836,8 @@ void drm_event_cancel_free(struct drm_device *dev,
 EXPORT_SYMBOL(drm_event_cancel_free);
 
 static void drm_send_event_helper(struct drm_device *dev,
-			   struct drm_pending_event *e, ktime_t timestamp)
+			   struct drm_pending_event *e, ktime_t timestamp,
+			   struct list_head *wake_list)
 {
 	assert_spin_locked(&dev->event_lock);
 
@@ -811,6 +863,15 @@ static void drm_send_event_helper(struct drm_device *dev,
 	list_del(&e->pending_link);
 	list_add_tail(&e->link,
 		      &e->file_priv->event_list);
+	drm_event_stat(sent, 1);
+
+	if (wake_list) {
+		if (list_empty(&e->file_priv->event_wake_link))
+			list_add_tail(&e->file_priv->event_wake_link, wake_list);
+		return;
+	}
+
+	drm_event_stat(wakeups, 1);
 #ifdef __linux__
 	wake_up_interruptible_poll(&e->file_priv->event_wait,
 		EPOLLIN | EPOLLRDNORM);
@@ -819,6 +880,53 @@ static void drm_send_event_helper(struct drm_device *dev,
 #endif
 }
 
+/**
+ * drm_send_event_batched_locked - queue a DRM event without waking the reader
+ * @dev: DRM device
+ * @e: DRM event to deliver
+ * @timestamp: timestamp to set for the fence event, see
+ * drm_send_event_timestamp_locked()
+ * @wake_list: list collecting the files to wake up
+ *
+ * Like drm_send_event_timestamp_locked(), but instead of waking up the
+ * reader the file is added to @wake_list once. Callers delivering several
+ * events at once then wake every file a single time with
+ * drm_send_event_batch_wake(), before dropping &drm_device.event_lock.
+ */
+void drm_send_event_batched_locked(struct drm_device *dev,
+				   struct drm_pending_event *e,
+				   ktime_t timestamp,
+				   struct list_head *wake_list)
+{
+	drm_send_event_helper(dev, e, timestamp, wake_list);
+}
+
+/**
+ * drm_send_event_batch_wake - wake up the files of a batch of events
+ * @dev: DRM device
+ * @wake_list: list filled by drm_send_event_batched_locked()
+ *
+ * Callers must hold &drm_device.event_lock.
+ */
+void drm_send_event_batch_wake(struct drm_device *dev,
+			       struct list_head *wake_list)
+{
+	struct drm_file *file_priv, *tmp;
+
+	assert_spin_locked(&dev->event_lock);
+
+	list_for_each_entry_safe(file_priv, tmp, wake_list, event_wake_link) {
+		list_del_init(&file_priv->event_wake_link);
+		drm_event_stat(wakeups, 1);
+#ifdef __linux__
+		wake_up_interruptible_poll(&file_priv->event_wait,
+			EPOLLIN | EPOLLRDNORM);
+#elif defined(__FreeBSD__)
+		wake_up_interruptible(&file_priv->event_wait);
+#endif
+	}
+}
+
 /**
  * drm_send_event_timestamp_locked - send DRM event to file descriptor
  * @dev: DRM device
@@ -838,7 +946,7 @@ static void drm_send_event_helper(struct drm_device *dev,
 void drm_send_event_timestamp_locked(struct drm_device *dev,
 				     struct drm_pending_event *e, ktime_t timestamp)
 {
-	drm_send_event_helper(dev, e, timestamp);
+	drm_send_event_helper(dev, e, timestamp, NULL);
 }
 EXPORT_SYMBOL(drm_send_event_timestamp_locked);
 
@@ -858,7 +966,7 @@ EXPORT_SYMBOL(drm_send_event_timestamp_locked);
  */
 void drm_send_event_locked(struct drm_device *dev, struct drm_pending_event *e)
 {
-	drm_send_event_helper(dev, e, 0);
+	drm_send_event_helper(dev, e, 0, NULL);
 }
 EXPORT_SYMBOL(drm_send_event_locked);
 
@@ -882,7 +990,7 @@ void drm_send_event(struct drm_device *dev, struct drm_pending_event *e)
 	unsigned long irqflags;
 
 	spin_lock_irqsave(&dev->event_lock, irqflags);
-	drm_send_event_helper(dev, e, 0);
+	drm_send_event_helper(dev, e, 0, NULL);
 	spin_unlock_irqrestore(&dev->event_lock, irqflags);
 }
 EXPORT_SYMBOL(drm_send_event);
@@ -997,25 +1105,35 @@ EXPORT_SYMBOL(drm_show_memory_stats);
  */
 void drm_show_fdinfo(struct seq_file *m, struct file *f)
 {
-	struct drm_file *file = f->private_data;
-	struct drm_device *dev = file->minor->dev;
 	struct drm_printer p = drm_seq_file_printer(m);
 
-	drm_printf(&p, "drm-driver:\t%s\n", dev->driver->name);
-	drm_printf(&p, "drm-client-id:\t%llu\n", file->client_id);
+	drm_print_fdinfo(&p, f->private_data);
+}
+EXPORT_SYMBOL(drm_show_fdinfo);
+
+/*
+ * Print the fdinfo usage stats of @file to @p. Shared between
+ * drm_show_fdinfo() and the FreeBSD hw.dri.N.fdinfo sysctl, which has no
+ * procfs to hang off.
+ */
+void drm_print_fdinfo(struct drm_printer *p, struct drm_file *file)
+{
+	struct drm_device *dev = file->minor->dev;
+
+	drm_printf(p, "drm-driver:\t%s\n", dev->driver->name);
+	drm_printf(p, "drm-client-id:\t%llu\n", file->client_id);
 
 	if (dev_is_pci(dev->dev)) {
 		struct pci_dev *pdev = to_pci_dev(dev->dev);
 
-		drm_printf(&p, "drm-pdev:\t%04x:%02x:%02x.%d\n",
+		drm_printf(p, "drm-pdev:\t%04x:%02x:%02x.%d\n",
 			   pci_domain_nr(pdev->bus), pdev->bus->number,
 			   PCI_SLOT(pdev->devfn), PCI_FUNC(pdev->devfn));
 	}
 
 	if (dev->driver->show_fdinfo)
-		dev->driver->show_fdinfo(&p, file);
+		dev->driver->show_fdinfo(p, file);
 }
-EXPORT_SYMBOL(drm_show_fdinfo);
 
 /**
  * mock_drm_getfile - Create a new struct file for the drm device
@@ -659,7 +659,13 @@ void drm_gem_put_pages(struct drm_gem_object *obj, struct page **pages,
 EXPORT_SYMBOL(drm_gem_put_pages);
 #endif
 
-static int objects_lookup(struct drm_file *filp, u32 *handle, int count,
+/*
+ * Handle arrays up to this size are copied in on the stack by
+ * drm_gem_objects_lookup().
+ */
+#define DRM_GEM_LOOKUP_STACK_HANDLES 32
+
+static int objects_lookup(struct drm_file *filp, const u32 *handle, int count,
 			  struct drm_gem_object **objs)
 {
 	int i, ret = 0;
@@ -671,6 +677,7 @@ static int objects_lookup(struct drm_file *filp, u32 *handle, int count,
 		/* Check if we currently have a reference on the object */
 		obj = idr_find(&filp->object_idr, handle[i]);
 		if (!obj) {
+			objs[i] = NULL;
 			ret = -ENOENT;
 			break;
 		}
@@ -705,7 +712,8 @@ int drm_gem_objects_lookup(struct drm_file *filp, void __user *bo_handles,
 			   int count, struct drm_gem_object ***objs_out)
 {
 	int ret;
-	u32 *handles;
+	u32 stack_handles[DRM_GEM_LOOKUP_STACK_HANDLES];
+	u32 *handles = stack_handles;
 	struct drm_gem_object **objs;
 
 	if (!count)
@@ -718,10 +726,12 @@ int drm_gem_objects_lookup(struct drm_file *filp, void __user *bo_handles,
 
 	*objs_out = objs;
 
-	handles = kvmalloc_array(count, sizeof(u32), GFP_KERNEL);
-	if (!handles) {
-		ret = -ENOMEM;
-		goto out;
+	if (count > ARRAY_SIZE(stack_handles)) {
+		handles = kvmalloc_array(count, sizeof(u32), GFP_KERNEL);
+		if (!handles) {
+			ret = -ENOMEM;
+			goto out;
+		}
 	}
 
 	if (copy_from_user(handles, bo_handles, count * sizeof(u32))) {
@@ -732,12 +742,45 @@ int drm_gem_objects_lookup(struct drm_file *filp, void __user *bo_handles,
 
 	ret = objects_lookup(filp, handles, count, objs);
 out:
-	kvfree(handles);
+	if (handles != stack_handles)
+		kvfree(handles);
 	return ret;
 
 }
 EXPORT_SYMBOL(drm_gem_objects_lookup);
 
+/**
+ * drm_gem_objects_lookup_array - look up GEM objects from a kernel handle array
+ * @filp: DRM file private date
+ * @handles: array of userspace handles, already copied in
+ * @count: size of @handles
+ * @objs: array of at least @count entries receiving the objects
+ *
+ * Resolves all of @handles in one pass, taking &drm_file.table_lock only
+ * once. Intended for submission paths which already copied the handles in
+ * together with other per-buffer data.
+ *
+ * Returns:
+ *
+ * 0 on success with a reference on every object in @objs, which needs to be
+ * released with drm_gem_object_put(). -ENOENT if any handle is invalid, in
+ * which case no references are held.
+ */
+int drm_gem_objects_lookup_array(struct drm_file *filp, const u32 *handles,
+				 int count, struct drm_gem_object **objs)
+{
+	int i, ret;
+
+	ret = objects_lookup(filp, handles, count, objs);
+	if (ret) {
+		for (i = 0; i < count && objs[i]; i++)
+			drm_gem_object_put(objs[i]);
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL(drm_gem_objects_lookup_array);
+
 /**
  * drm_gem_object_lookup - look up a GEM object from its handle
  * @filp: DRM file private date
@@ -160,6 +160,12 @@
  * allocations are possible (e.g. to allocate GPU page tables) and once in the
  * dma-fence signalling critical path.
  *
+ * Drivers processing a whole bind ioctl worth of map and unmap requests can
+ * use drm_gpuvm_sm_batch_ops_create() instead, which builds a single
+ * &drm_gpuva_ops for an array of &drm_gpuvm_bind_req, coalesces adjacent
+ * requests and carves the operations from a few larger allocations rather
+ * than allocating each of them separately.
+ *
  * To update the &drm_gpuvm's view of the GPU VA space drm_gpuva_insert() and
  * drm_gpuva_remove() may be used. These functions can safely be used from
  * &drm_gpuvm_ops callbacks originating from drm_gpuvm_sm_map() or
@@ -1004,6 +1010,7 @@ drm_gpuvm_init(struct drm_gpuvm *gpuvm, const char *name,
 {
 	gpuvm->rb.tree = RB_ROOT_CACHED;
 	INIT_LIST_HEAD(&gpuvm->rb.list);
+	gpuvm->rb.last = NULL;
 
 	INIT_LIST_HEAD(&gpuvm->extobj.list);
 	spin_lock_init(&gpuvm->extobj.lock);
@@ -1781,7 +1788,12 @@ EXPORT_SYMBOL_GPL(drm_gpuva_insert);
 static void
 __drm_gpuva_remove(struct drm_gpuva *va)
 {
-	drm_gpuva_it_remove(va, &va->vm->rb.tree);
+	struct drm_gpuvm *gpuvm = va->vm;
+
+	if (gpuvm->rb.last == va)
+		WRITE_ONCE(gpuvm->rb.last, NULL);
+
+	drm_gpuva_it_remove(va, &gpuvm->rb.tree);
 	list_del_init(&va->rb.entry);
 }
 
@@ -1879,6 +1891,46 @@ drm_gpuva_unlink(struct drm_gpuva *va)
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_unlink);
 
+/*
+ * Return the first &drm_gpuva overlapping [start, last], like
+ * drm_gpuva_it_iter_first().
+ *
+ * Faults and binds tend to hit the same or the following mapping as the
+ * previous lookup, hence try the last hit and its successor in the sorted
+ * list before descending the tree. Since mappings don't overlap, the last hit
+ * is the answer if it contains @start; if it ends before @start, nothing lies
+ * between it and its successor.
+ *
+ * Lookups may run concurrently under a shared lock, the cache only ever points
+ * to a mapping in the tree since removal requires exclusive access.
+ */
+static struct drm_gpuva *
+drm_gpuvm_lookup(struct drm_gpuvm *gpuvm, u64 start, u64 last)
+{
+	struct drm_gpuva *va = READ_ONCE(gpuvm->rb.last);
+	struct drm_gpuva *next;
+
+	if (va && GPUVA_START(va) <= start) {
+		if (GPUVA_LAST(va) >= start)
+			return va;
+
+		next = __drm_gpuva_next(va);
+		if (!next || GPUVA_START(next) > last)
+			return NULL;
+
+		if (GPUVA_LAST(next) >= start) {
+			WRITE_ONCE(gpuvm->rb.last, next);
+			return next;
+		}
+	}
+
+	va = drm_gpuva_it_iter_first(&gpuvm->rb.tree, start, last);
+	if (va)
+		WRITE_ONCE(gpuvm->rb.last, va);
+
+	return va;
+}
+
 /**
  * drm_gpuva_find_first() - find the first &drm_gpuva in the given range
  * @gpuvm: the &drm_gpuvm to search in
@@ -1893,7 +1945,7 @@ drm_gpuva_find_first(struct drm_gpuvm *gpuvm,
 {
 	u64 last = addr + range - 1;
 
-	return drm_gpuva_it_iter_first(&gpuvm->rb.tree, addr, last);
+	return drm_gpuvm_lookup(gpuvm, addr, last);
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_find_first);
 
@@ -1944,7 +1996,7 @@ drm_gpuva_find_prev(struct drm_gpuvm *gpuvm, u64 start)
 	if (!drm_gpuvm_range_valid(gpuvm, start - 1, 1))
 		return NULL;
 
-	return drm_gpuva_it_iter_first(&gpuvm->rb.tree, start - 1, start);
+	return drm_gpuvm_lookup(gpuvm, start - 1, start);
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_find_prev);
 
@@ -1966,7 +2018,7 @@ drm_gpuva_find_next(struct drm_gpuvm *gpuvm, u64 end)
 	if (!drm_gpuvm_range_valid(gpuvm, end, 1))
 		return NULL;
 
-	return drm_gpuva_it_iter_first(&gpuvm->rb.tree, end, end + 1);
+	return drm_gpuvm_lookup(gpuvm, end, end + 1);
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_find_next);
 
@@ -2013,7 +2065,8 @@ EXPORT_SYMBOL_GPL(drm_gpuva_map);
  * @op: the &drm_gpuva_op_remap to initialize @prev and @next with
  *
  * Removes the currently mapped &drm_gpuva and remaps it using @prev and/or
- * @next.
+ * @next. If a later request of the same batch splits or unmaps @next again,
+ * its unmap operation is pointed at @next.
  */
 void
 drm_gpuva_remap(struct drm_gpuva *prev,
@@ -2033,6 +2086,9 @@ drm_gpuva_remap(struct drm_gpuva *prev,
 	if (op->next) {
 		drm_gpuva_init_from_op(next, op->next);
 		drm_gpuva_insert(gpuvm, next);
+
+		if (op->next_unmap)
+			op->next_unmap->va = next;
 	}
 }
 EXPORT_SYMBOL_GPL(drm_gpuva_remap);
@@ -2420,15 +2476,10 @@ gpuva_op_free(struct drm_gpuvm *gpuvm,
 }
 
 static int
-drm_gpuva_sm_step(struct drm_gpuva_op *__op,
-		  void *priv)
+__drm_gpuva_sm_step(struct drm_gpuvm *gpuvm,
+		    struct drm_gpuva_ops *ops,
+		    struct drm_gpuva_op *__op)
 {
-	struct {
-		struct drm_gpuvm *vm;
-		struct drm_gpuva_ops *ops;
-	} *args = priv;
-	struct drm_gpuvm *gpuvm = args->vm;
-	struct drm_gpuva_ops *ops = args->ops;
 	struct drm_gpuva_op *op;
 
 	op = gpuva_op_alloc(gpuvm);
@@ -2475,12 +2526,228 @@ err:
 	return -ENOMEM;
 }
 
+static int
+drm_gpuva_sm_step(struct drm_gpuva_op *__op,
+		  void *priv)
+{
+	struct {
+		struct drm_gpuvm *vm;
+		struct drm_gpuva_ops *ops;
+	} *args = priv;
+
+	return __drm_gpuva_sm_step(args->vm, args->ops, __op);
+}
+
 static const struct drm_gpuvm_ops gpuvm_list_ops = {
 	.sm_step_map = drm_gpuva_sm_step,
 	.sm_step_remap = drm_gpuva_sm_step,
 	.sm_step_unmap = drm_gpuva_sm_step,
 };
 
+/*
+ * A batch op carries the remap pieces inline, such that a single slot of a
+ * &drm_gpuva_op_chunk holds everything one step of the split and merge walk
+ * produces.
+ */
+struct drm_gpuva_batch_op {
+	struct drm_gpuva_op op;
+	struct drm_gpuva_op_map prev;
+	struct drm_gpuva_op_map next;
+	struct drm_gpuva_op_unmap unmap;
+};
+
+struct drm_gpuva_op_chunk {
+	struct drm_gpuva_op_chunk *next;
+	unsigned int used;
+	unsigned int size;
+	struct drm_gpuva_batch_op ops[];
+};
+
+/* Initial number of ops reserved per request of a batch. */
+#define DRM_GPUVA_BATCH_OPS_PER_REQ	2
+
+struct drm_gpuva_batch {
+	struct drm_gpuvm *vm;
+	struct drm_gpuva_ops *ops;
+	/* last &drm_gpuva split or unmapped by the previous request */
+	struct drm_gpuva *prev_va;
+	/* the remap splitting @prev_va, if it was split */
+	struct drm_gpuva_op_remap *prev_remap;
+	/* last &drm_gpuva split or unmapped by the current request */
+	struct drm_gpuva *last_va;
+	struct drm_gpuva_op_remap *last_remap;
+};
+
+static struct drm_gpuva_op_chunk *
+gpuva_op_chunk_alloc(unsigned int size)
+{
+	struct drm_gpuva_op_chunk *chunk;
+
+	chunk = kvzalloc(struct_size(chunk, ops, size), GFP_KERNEL);
+	if (unlikely(!chunk))
+		return NULL;
+
+	chunk->size = size;
+
+	return chunk;
+}
+
+static struct drm_gpuva_batch_op *
+gpuva_batch_op_alloc(struct drm_gpuva_ops *ops)
+{
+	struct drm_gpuva_op_chunk *chunk = ops->pool;
+
+	if (chunk->used == chunk->size) {
+		chunk = gpuva_op_chunk_alloc(chunk->size * 2);
+		if (unlikely(!chunk))
+			return NULL;
+
+		chunk->next = ops->pool;
+		ops->pool = chunk;
+	}
+
+	return &chunk->ops[chunk->used++];
+}
+
+/*
+ * All requests of a batch are resolved against the same view of the GPU VA
+ * space, hence a mapping split by two requests is split twice from its
+ * original bounds. Since the requests are sorted and don't overlap, the later
+ * split can only cut into the piece the earlier one kept after its hole.
+ * Re-base it on that piece: it now only keeps the part between the two holes
+ * and unmaps the &drm_gpuva inserted for the piece, which drm_gpuva_remap()
+ * fills in once the earlier remap was processed. If the holes touch and the
+ * later one runs to the end of the mapping, nothing is kept and the caller
+ * turns the remap into an unmap of the piece.
+ */
+static int
+drm_gpuva_sm_batch_rebase(struct drm_gpuva_op_remap *prev_remap,
+			  struct drm_gpuva_op_remap *r,
+			  struct drm_gpuva_op_map *prev,
+			  struct drm_gpuva_op_unmap *unmap)
+{
+	struct drm_gpuva_op_map *piece = prev_remap->next;
+	u64 hole;
+
+	if (unlikely(!piece || !r->prev))
+		return -EINVAL;
+
+	hole = r->prev->va.addr + r->prev->va.range;
+	if (unlikely(hole < piece->va.addr))
+		return -EINVAL;
+
+	if (hole > piece->va.addr) {
+		*prev = *piece;
+		prev->va.range = hole - piece->va.addr;
+		r->prev = prev;
+	} else {
+		r->prev = NULL;
+	}
+
+	*unmap = *r->unmap;
+	unmap->va = NULL;
+	r->unmap = unmap;
+
+	return 0;
+}
+
+static int
+drm_gpuva_sm_batch_step(struct drm_gpuva_op *__op,
+			void *priv)
+{
+	struct drm_gpuva_batch *batch = priv;
+	struct drm_gpuva_ops *ops = batch->ops;
+	struct drm_gpuva_op_remap *prev_remap = NULL;
+	struct drm_gpuva_op_map rebased_prev;
+	struct drm_gpuva_op_unmap rebased_unmap;
+	struct drm_gpuva_op rebased;
+	struct drm_gpuva_batch_op *bop;
+	struct drm_gpuva_op *op;
+	struct drm_gpuva *va = NULL;
+	int ret;
+
+	if (__op->op == DRM_GPUVA_OP_REMAP)
+		va = __op->remap.unmap->va;
+	else if (__op->op == DRM_GPUVA_OP_UNMAP)
+		va = __op->unmap.va;
+
+	if (va && unlikely(va == batch->prev_va)) {
+		/* Only the middle of the mapping can be left for us. */
+		prev_remap = batch->prev_remap;
+		if (unlikely(!prev_remap || __op->op != DRM_GPUVA_OP_REMAP))
+			return -EINVAL;
+
+		rebased = *__op;
+		ret = drm_gpuva_sm_batch_rebase(prev_remap, &rebased.remap,
+						&rebased_prev, &rebased_unmap);
+		if (ret)
+			return ret;
+
+		/* Nothing of the piece is kept, it is unmapped as a whole. */
+		if (!rebased.remap.prev && !rebased.remap.next) {
+			rebased.op = DRM_GPUVA_OP_UNMAP;
+			rebased.unmap = rebased_unmap;
+		}
+
+		__op = &rebased;
+	}
+
+	if (!ops->pool) {
+		ret = __drm_gpuva_sm_step(batch->vm, ops, __op);
+		if (ret)
+			return ret;
+
+		op = list_last_entry(&ops->list, struct drm_gpuva_op, entry);
+		goto out;
+	}
+
+	bop = gpuva_batch_op_alloc(ops);
+	if (unlikely(!bop))
+		return -ENOMEM;
+
+	bop->op = *__op;
+	op = &bop->op;
+
+	if (__op->op == DRM_GPUVA_OP_REMAP) {
+		struct drm_gpuva_op_remap *__r = &__op->remap;
+		struct drm_gpuva_op_remap *r = &bop->op.remap;
+
+		bop->unmap = *__r->unmap;
+		r->unmap = &bop->unmap;
+
+		if (__r->prev) {
+			bop->prev = *__r->prev;
+			r->prev = &bop->prev;
+		}
+
+		if (__r->next) {
+			bop->next = *__r->next;
+			r->next = &bop->next;
+		}
+	}
+
+	list_add_tail(&bop->op.entry, &ops->list);
+
+out:
+	if (prev_remap)
+		prev_remap->next_unmap = op->op == DRM_GPUVA_OP_REMAP ?
+					 op->remap.unmap : &op->unmap;
+
+	if (va) {
+		batch->last_va = va;
+		batch->last_remap = op->op == DRM_GPUVA_OP_REMAP ?
+				    &op->remap : NULL;
+	}
+
+	return 0;
+}
+
+static const struct drm_gpuvm_ops gpuvm_batch_ops = {
+	.sm_step_map = drm_gpuva_sm_batch_step,
+	.sm_step_remap = drm_gpuva_sm_batch_step,
+	.sm_step_unmap = drm_gpuva_sm_batch_step,
+};
+
 /**
  * drm_gpuvm_sm_map_ops_create() - creates the &drm_gpuva_ops to split and merge
  * @gpuvm: the &drm_gpuvm representing the GPU VA space
@@ -2610,6 +2877,124 @@ err_free_ops:
 }
 EXPORT_SYMBOL_GPL(drm_gpuvm_sm_unmap_ops_create);
 
+/**
+ * drm_gpuvm_sm_batch_ops_create() - creates the &drm_gpuva_ops for a batch of
+ * map and unmap requests
+ * @gpuvm: the &drm_gpuvm representing the GPU VA space
+ * @reqs: the array of &drm_gpuvm_bind_req
+ * @count: the number of entries in @reqs
+ *
+ * This function creates a single list of operations to perform splitting and
+ * merging of existent mapping(s) for all the given requests, as if
+ * drm_gpuvm_sm_map_ops_create() or drm_gpuvm_sm_unmap_ops_create() had been
+ * called for each of them and the results had been concatenated.
+ *
+ * The requests must be sorted by address and must not overlap. Adjacent
+ * requests unmapping, or mapping the same &drm_gem_object at contiguous
+ * offsets, are coalesced into a single request. Since all requests are
+ * resolved against the current view of the GPU VA space, a single existent
+ * mapping split by several requests, e.g. a large sparse mapping several holes
+ * are punched into, is remapped once per request: each later remap keeps the
+ * part up to its hole of the piece the previous one kept, and unmaps that
+ * piece. Its &drm_gpuva_op_unmap.va is NULL until drm_gpuva_remap() processed
+ * the previous remap, so drivers must use that helper for batches.
+ *
+ * Unless the driver provides &drm_gpuvm_ops.op_alloc, the operations are
+ * carved from chunks sized from @count rather than allocated one by one.
+ *
+ * The same rules as for drm_gpuvm_sm_map_ops_create() apply for processing the
+ * list and for updating the &drm_gpuvm's view of the GPU VA space. After the
+ * caller finished processing the returned &drm_gpuva_ops, they must be freed
+ * with &drm_gpuva_ops_free.
+ *
+ * Returns: a pointer to the &drm_gpuva_ops on success, an ERR_PTR on failure
+ */
+struct drm_gpuva_ops *
+drm_gpuvm_sm_batch_ops_create(struct drm_gpuvm *gpuvm,
+			      const struct drm_gpuvm_bind_req *reqs,
+			      unsigned int count)
+{
+	const struct drm_gpuvm_ops *fn = gpuvm->ops;
+	struct drm_gpuva_batch batch = {};
+	struct drm_gpuva_ops *ops;
+	unsigned int i, j;
+	int ret;
+
+	for (i = 0; i < count; i++) {
+		if (unlikely(drm_gpuvm_check_overflow(reqs[i].addr,
+						      reqs[i].range)))
+			return ERR_PTR(-EINVAL);
+
+		if (i && unlikely(reqs[i].addr <
+				  reqs[i - 1].addr + reqs[i - 1].range))
+			return ERR_PTR(-EINVAL);
+	}
+
+	ops = kzalloc(sizeof(*ops), GFP_KERNEL);
+	if (unlikely(!ops))
+		return ERR_PTR(-ENOMEM);
+
+	INIT_LIST_HEAD(&ops->list);
+
+	/* Drivers embedding &drm_gpuva_op need their own allocator. */
+	if (!(fn && fn->op_alloc) && count) {
+		ops->pool = gpuva_op_chunk_alloc(count *
+						 DRM_GPUVA_BATCH_OPS_PER_REQ);
+		if (unlikely(!ops->pool)) {
+			ret = -ENOMEM;
+			goto err_free_ops;
+		}
+	}
+
+	batch.vm = gpuvm;
+	batch.ops = ops;
+
+	for (i = 0; i < count; i = j) {
+		const struct drm_gpuvm_bind_req *req = &reqs[i];
+		u64 range = req->range;
+
+		for (j = i + 1; j < count; j++) {
+			const struct drm_gpuvm_bind_req *n = &reqs[j];
+
+			if (n->addr != req->addr + range || n->obj != req->obj)
+				break;
+
+			if (req->obj && n->offset != req->offset + range)
+				break;
+
+			range += n->range;
+		}
+
+		if (req->obj)
+			ret = __drm_gpuvm_sm_map(gpuvm, &gpuvm_batch_ops, &batch,
+						 req->addr, range,
+						 req->obj, req->offset);
+		else
+			ret = __drm_gpuvm_sm_unmap(gpuvm, &gpuvm_batch_ops,
+						   &batch, req->addr, range);
+		if (ret)
+			goto err_free_ops;
+
+		/*
+		 * A request leaving an existent mapping as it is, e.g. mapping
+		 * what's mapped already, keeps the previous one's split.
+		 */
+		if (batch.last_va) {
+			batch.prev_va = batch.last_va;
+			batch.prev_remap = batch.last_remap;
+			batch.last_va = NULL;
+			batch.last_remap = NULL;
+		}
+	}
+
+	return ops;
+
+err_free_ops:
+	drm_gpuva_ops_free(gpuvm, ops);
+	return ERR_PTR(ret);
+}
+EXPORT_SYMBOL_GPL(drm_gpuvm_sm_batch_ops_create);
+
 /**
  * drm_gpuvm_prefetch_ops_create() - creates the &drm_gpuva_ops to prefetch
  * @gpuvm: the &drm_gpuvm representing the GPU VA space
@@ -2732,6 +3117,19 @@ drm_gpuva_ops_free(struct drm_gpuvm *gpuvm,
 {
 	struct drm_gpuva_op *op, *next;
 
+	if (ops->pool) {
+		struct drm_gpuva_op_chunk *chunk, *cnext;
+
+		/* Batch ops, including their remap pieces, live in the pool. */
+		for (chunk = ops->pool; chunk; chunk = cnext) {
+			cnext = chunk->next;
+			kvfree(chunk);
+		}
+
+		kfree(ops);
+		return;
+	}
+
 	drm_gpuva_for_each_op_safe(op, next, ops) {
 		list_del(&op->entry);
 
@@ -44,6 +44,7 @@ struct drm_framebuffer;
 struct drm_gem_object;
 struct drm_master;
 struct drm_minor;
+struct drm_pending_event;
 struct drm_prime_file_private;
 struct drm_printer;
 struct drm_vblank_crtc;
@@ -54,6 +55,13 @@ bool drm_dev_needs_global_mutex(struct drm_device *dev);
 struct drm_file *drm_file_alloc(struct drm_minor *minor);
 void drm_file_free(struct drm_file *file);
 void drm_lastclose(struct drm_device *dev);
+void drm_send_event_batched_locked(struct drm_device *dev,
+				   struct drm_pending_event *e,
+				   ktime_t timestamp,
+				   struct list_head *wake_list);
+void drm_send_event_batch_wake(struct drm_device *dev,
+			       struct list_head *wake_list);
+void drm_print_fdinfo(struct drm_printer *p, struct drm_file *file);
 
 #ifdef CONFIG_PCI
 
@@ -283,6 +291,10 @@ int drm_syncobj_signal_ioctl(struct drm_device *dev, void *data,
 			     struct drm_file *file_private);
 int drm_syncobj_timeline_signal_ioctl(struct drm_device *dev, void *data,
 				      struct drm_file *file_private);
+#ifdef __FreeBSD__
+int drm_syncobj_batch_ioctl(struct drm_device *dev, void *data,
+			    struct drm_file *file_private);
+#endif
 int drm_syncobj_query_ioctl(struct drm_device *dev, void *data,
 			    struct drm_file *file_private);
 
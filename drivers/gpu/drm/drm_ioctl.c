@@ -37,6 +37,9 @@
 #include <drm/drm_crtc.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_file.h>
+#ifdef __FreeBSD__
+#include <drm/drm_freebsd.h>
+#endif
 #include <drm/drm_ioctl.h>
 #include <drm/drm_print.h>
 
@@ -689,6 +692,16 @@ static const struct drm_ioctl_desc drm_ioctls[] = {
 
 #define DRM_CORE_IOCTL_COUNT	ARRAY_SIZE(drm_ioctls)
 
+#ifdef __FreeBSD__
+/* Ioctl table of the FreeBSD private DRM_FREEBSD_IOCTL_BASE group */
+static const struct drm_ioctl_desc drm_freebsd_ioctls[] = {
+	DRM_IOCTL_DEF(DRM_IOCTL_SYNCOBJ_BATCH, drm_syncobj_batch_ioctl,
+		      DRM_RENDER_ALLOW),
+};
+
+#define DRM_FREEBSD_IOCTL_COUNT	ARRAY_SIZE(drm_freebsd_ioctls)
+#endif
+
 /**
  * DOC: driver specific ioctls
  *
@@ -791,6 +804,14 @@ long drm_ioctl(struct file *filp,
 		return -ENODEV;
 
 #ifdef __FreeBSD__
+	if (IOCGROUP(cmd) == DRM_FREEBSD_IOCTL_BASE) {
+		if (nr >= DRM_FREEBSD_IOCTL_COUNT)
+			goto err_i1;
+		nr = array_index_nospec(nr, DRM_FREEBSD_IOCTL_COUNT);
+		ioctl = &drm_freebsd_ioctls[nr];
+		goto have_ioctl;
+	}
+
 	if (IOCGROUP(cmd) != DRM_IOCTL_BASE) {
 		DRM_DEBUG("bad ioctl group 0x%x\n", (int)IOCGROUP(cmd));
 		return -EINVAL;
@@ -818,6 +839,9 @@ long drm_ioctl(struct file *filp,
 		ioctl = &drm_ioctls[nr];
 	}
 
+#ifdef __FreeBSD__
+have_ioctl:
+#endif
 	drv_size = _IOC_SIZE(ioctl->cmd);
 	out_size = in_size = _IOC_SIZE(cmd);
 	if ((cmd & ioctl->cmd & IOC_IN) == 0)
@@ -840,6 +864,23 @@ long drm_ioctl(struct file *filp,
 		goto err_i1;
 	}
 
+#ifdef __FreeBSD__
+	/*
+	 * The FreeBSD ioctl layer has already copied the argument into a
+	 * kernel buffer of _IOC_SIZE(cmd) bytes and copies it back out on
+	 * success, linuxkpi's copy_from_user() and copy_to_user() only
+	 * memcpy() from and to that buffer. When the command matches our
+	 * definition exactly, hand that buffer to the handler instead.
+	 */
+	if (cmd == ioctl->cmd && current->bsd_ioctl_data != NULL &&
+	    current->bsd_ioctl_len >= ksize) {
+		kdata = current->bsd_ioctl_data;
+		retcode = drm_ioctl_kernel(filp, func, kdata, ioctl->flags);
+		kdata = NULL;
+		goto err_i1;
+	}
+#endif
+
 	if (ksize <= sizeof(stack_kdata)) {
 		kdata = stack_kdata;
 	} else {
@@ -246,10 +246,65 @@ static void insert_hole_size(struct rb_root_cached *root,
 RB_DECLARE_CALLBACKS_MAX(static, augment_callbacks,
 			 struct drm_mm_node, rb_hole_addr,
 			 u64, subtree_max_hole, HOLE_SIZE)
+#elif defined(__FreeBSD__)
+/*
+ * linuxkpi's rb_insert_color() and rb_erase() know nothing about augmented
+ * trees, so subtree_max_hole went stale as soon as the hole address tree was
+ * rebalanced and the LOW/HIGH searches pruned subtrees that did hold a large
+ * enough hole. Generate the hole address tree from sys/tree.h instead and let
+ * RB_AUGMENT_CHECK() propagate subtree_max_hole through every rotation.
+ */
+RB_HEAD(drm_mm_holes_addr, rb_node);
+
+static bool drm_mm_hole_addr_augment(struct rb_node *rb)
+{
+	struct drm_mm_node *node =
+		rb_entry(rb, struct drm_mm_node, rb_hole_addr);
+	u64 max = node->hole_size;
+
+	if (rb->rb_left &&
+	    rb_entry(rb->rb_left, struct drm_mm_node,
+		     rb_hole_addr)->subtree_max_hole > max)
+		max = rb_entry(rb->rb_left, struct drm_mm_node,
+			       rb_hole_addr)->subtree_max_hole;
+	if (rb->rb_right &&
+	    rb_entry(rb->rb_right, struct drm_mm_node,
+		     rb_hole_addr)->subtree_max_hole > max)
+		max = rb_entry(rb->rb_right, struct drm_mm_node,
+			       rb_hole_addr)->subtree_max_hole;
+
+	if (node->subtree_max_hole == max)
+		return false;
+
+	node->subtree_max_hole = max;
+	return true;
+}
+
+static int drm_mm_hole_addr_cmp(struct rb_node *a, struct rb_node *b)
+{
+	u64 x = HOLE_ADDR(rb_entry(a, struct drm_mm_node, rb_hole_addr));
+	u64 y = HOLE_ADDR(rb_entry(b, struct drm_mm_node, rb_hole_addr));
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * linuxkpi replaces sys/tree.h's RB_ROOT() with Linux's initializer, restore
+ * it for the generated functions like linux_compat.c does.
+ */
+#undef RB_ROOT
+#define RB_ROOT(head) (head)->rbh_root
+#undef RB_AUGMENT_CHECK
+#define RB_AUGMENT_CHECK(rb) drm_mm_hole_addr_augment(rb)
+RB_GENERATE_STATIC(drm_mm_holes_addr, rb_node, __entry, drm_mm_hole_addr_cmp);
+#undef RB_AUGMENT_CHECK
+#undef RB_ROOT
+#define RB_ROOT (struct rb_root) { NULL }
 #endif
 
 static void insert_hole_addr(struct rb_root *root, struct drm_mm_node *node)
 {
+#ifdef __linux__
 	struct rb_node **link = &root->rb_node, *rb_parent = NULL;
 	u64 start = HOLE_ADDR(node), subtree_max_hole = node->subtree_max_hole;
 	struct drm_mm_node *parent;
@@ -266,10 +321,12 @@ static void insert_hole_addr(struct rb_root *root, struct drm_mm_node *node)
 	}
 
 	rb_link_node(&node->rb_hole_addr, rb_parent, link);
-#ifdef __linux__
 	rb_insert_augmented(&node->rb_hole_addr, root, &augment_callbacks);
 #elif defined(__FreeBSD__)
-	rb_insert_color(&node->rb_hole_addr, root);
+	/* Start from 0 so the insertion always propagates the new hole. */
+	node->subtree_max_hole = 0;
+	RB_INSERT(drm_mm_holes_addr, (struct drm_mm_holes_addr *)root,
+		  &node->rb_hole_addr);
 #endif
 }
 
@@ -298,7 +355,9 @@ static void rm_hole(struct drm_mm_node *node)
 	rb_erase_augmented(&node->rb_hole_addr, &node->mm->holes_addr,
 			   &augment_callbacks);
 #elif defined(__FreeBSD__)
-	rb_erase(&node->rb_hole_addr, &node->mm->holes_addr);
+	RB_REMOVE(drm_mm_holes_addr,
+		  (struct drm_mm_holes_addr *)&node->mm->holes_addr,
+		  &node->rb_hole_addr);
 #endif
 	node->hole_size = 0;
 	node->subtree_max_hole = 0;
@@ -509,6 +568,16 @@ static u64 rb_to_hole_size_or_zero(struct rb_node *rb)
 	return rb ? rb_to_hole_size(rb) : 0;
 }
 
+/*
+ * Number of holes DRM_MM_INSERT_BEST tries in size order before giving up on
+ * an exact best fit. Holes of the right size that sit outside the range, or
+ * that the alignment or color_adjust rules out, would otherwise be walked one
+ * by one. Past this point the search switches to the address tree, which only
+ * descends into subtrees inside [range_start, range_end) that hold a large
+ * enough hole, and takes the lowest one that fits.
+ */
+#define DRM_MM_BEST_TRIES 8
+
 /**
  * drm_mm_insert_node_in_range - ranged search for space and insert @node
  * @mm: drm_mm to allocate from
@@ -533,6 +602,7 @@ int drm_mm_insert_node_in_range(struct drm_mm * const mm,
 				enum drm_mm_insert_mode mode)
 {
 	struct drm_mm_node *hole;
+	unsigned int tries = 0;
 	u64 remainder_mask;
 	bool once;
 
@@ -554,11 +624,20 @@ int drm_mm_insert_node_in_range(struct drm_mm * const mm,
 	for (hole = first_hole(mm, range_start, range_end, size, mode);
 	     hole;
 	     hole = once ? NULL : next_hole(mm, hole, size, mode)) {
-		u64 hole_start = __drm_mm_hole_node_start(hole);
-		u64 hole_end = hole_start + hole->hole_size;
+		u64 hole_start, hole_end;
 		u64 adj_start, adj_end;
 		u64 col_start, col_end;
 
+		if (mode == DRM_MM_INSERT_BEST && ++tries > DRM_MM_BEST_TRIES) {
+			mode = DRM_MM_INSERT_LOW;
+			hole = find_hole_addr(mm, range_start, size);
+			if (!hole)
+				break;
+		}
+
+		hole_start = __drm_mm_hole_node_start(hole);
+		hole_end = hole_start + hole->hole_size;
+
 		if (mode == DRM_MM_INSERT_LOW && hole_start >= range_end)
 			break;
 
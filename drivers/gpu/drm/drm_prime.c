@@ -35,6 +35,7 @@
 #include <linux/export.h>
 #include <linux/dma-buf.h>
 #include <linux/rbtree.h>
+#include <linux/rculist.h>
 #include <linux/module.h>
 
 #include <drm/drm.h>
@@ -97,6 +98,9 @@ struct drm_prime_member {
 
 	struct rb_node dmabuf_rb;
 	struct rb_node handle_rb;
+
+	struct hlist_node dmabuf_hash;
+	struct rcu_head rcu;
 };
 
 static int drm_prime_add_buf_handle(struct drm_prime_file_private *prime_fpriv,
@@ -143,6 +147,9 @@ static int drm_prime_add_buf_handle(struct drm_prime_file_private *prime_fpriv,
 	rb_link_node(&member->handle_rb, rb, p);
 	rb_insert_color(&member->handle_rb, &prime_fpriv->handles);
 
+	hash_add_rcu(prime_fpriv->dmabuf_hash, &member->dmabuf_hash,
+		     (unsigned long)dma_buf);
+
 	return 0;
 }
 
@@ -191,6 +198,32 @@ static int drm_prime_lookup_buf_handle(struct drm_prime_file_private *prime_fpri
 	return -ENOENT;
 }
 
+/*
+ * Lockless variant of drm_prime_lookup_buf_handle() for the import fast path.
+ * The caller holds a reference on @dma_buf, and members keep theirs until
+ * they are unhashed, so a matching pointer always means the same buffer.
+ */
+static int drm_prime_lookup_buf_handle_rcu(struct drm_prime_file_private *prime_fpriv,
+					   struct dma_buf *dma_buf,
+					   uint32_t *handle)
+{
+	struct drm_prime_member *member;
+	int ret = -ENOENT;
+
+	rcu_read_lock();
+	hash_for_each_possible_rcu(prime_fpriv->dmabuf_hash, member,
+				   dmabuf_hash, (unsigned long)dma_buf) {
+		if (member->dma_buf == dma_buf) {
+			*handle = member->handle;
+			ret = 0;
+			break;
+		}
+	}
+	rcu_read_unlock();
+
+	return ret;
+}
+
 void drm_prime_remove_buf_handle(struct drm_prime_file_private *prime_fpriv,
 				 uint32_t handle)
 {
@@ -206,9 +239,10 @@ void drm_prime_remove_buf_handle(struct drm_prime_file_private *prime_fpriv,
 		if (member->handle == handle) {
 			rb_erase(&member->handle_rb, &prime_fpriv->handles);
 			rb_erase(&member->dmabuf_rb, &prime_fpriv->dmabufs);
+			hash_del_rcu(&member->dmabuf_hash);
 
 			dma_buf_put(member->dma_buf);
-			kfree(member);
+			kfree_rcu(member, rcu);
 			break;
 		} else if (member->handle < handle) {
 			rb = rb->rb_right;
@@ -225,6 +259,7 @@ void drm_prime_init_file_private(struct drm_prime_file_private *prime_fpriv)
 	mutex_init(&prime_fpriv->lock);
 	prime_fpriv->dmabufs = RB_ROOT;
 	prime_fpriv->handles = RB_ROOT;
+	hash_init(prime_fpriv->dmabuf_hash);
 }
 
 void drm_prime_destroy_file_private(struct drm_prime_file_private *prime_fpriv)
@@ -316,6 +351,13 @@ int drm_gem_prime_fd_to_handle(struct drm_device *dev,
 	if (IS_ERR(dma_buf))
 		return PTR_ERR(dma_buf);
 
+	/* Re-imports of a known buffer don't need the lock. */
+	if (drm_prime_lookup_buf_handle_rcu(&file_priv->prime,
+					    dma_buf, handle) == 0) {
+		dma_buf_put(dma_buf);
+		return 0;
+	}
+
 	mutex_lock(&file_priv->prime.lock);
 
 	ret = drm_prime_lookup_buf_handle(&file_priv->prime,
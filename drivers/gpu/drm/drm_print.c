@@ -31,6 +31,10 @@
 #include <linux/slab.h>
 #include <linux/stdarg.h>
 
+#ifdef __FreeBSD__
+#include <sys/sbuf.h>
+#endif
+
 #include <drm/drm.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_print.h>
@@ -192,6 +196,20 @@ void __drm_printfn_seq_file(struct drm_printer *p, struct va_format *vaf)
 }
 EXPORT_SYMBOL(__drm_printfn_seq_file);
 
+#ifdef __FreeBSD__
+void __drm_puts_sbuf(struct drm_printer *p, const char *str)
+{
+	sbuf_cat((struct sbuf *)(p->arg), str);
+}
+EXPORT_SYMBOL(__drm_puts_sbuf);
+
+void __drm_printfn_sbuf(struct drm_printer *p, struct va_format *vaf)
+{
+	sbuf_vprintf((struct sbuf *)(p->arg), vaf->fmt, *vaf->va);
+}
+EXPORT_SYMBOL(__drm_printfn_sbuf);
+#endif
+
 static void __drm_dev_vprintk(const struct device *dev, const char *level,
 			      const void *origin, const char *prefix,
 			      struct va_format *vaf)
@@ -38,15 +38,39 @@
  *
  * If we are asked to block we wait on all the oldest fence of all
  * rings. We just wait for any of those fence to complete.
+ *
+ * Ring mode (drm_suballoc_manager_init_ring()) drops the lock from the
+ * allocation path. Allocations are bumped off an ever increasing head
+ * with cmpxchg and handed back strictly in allocation order: freeing an
+ * allocation stores its length in a per-granule marker, from a fence
+ * callback if the fence has not signaled yet, and the tail is advanced over
+ * every retired allocation found at it. An allocation that is still busy
+ * holds back the reuse of everything allocated after it, so this suits
+ * managers whose fences mostly signal in submission order.
  */
 
 #include <drm/drm_suballoc.h>
 #include <drm/drm_print.h>
+#include <linux/math64.h>
+#include <linux/overflow.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
 #include <linux/wait.h>
 #include <linux/dma-fence.h>
 
+/*
+ * @head and @tail are byte positions that only ever grow, the offset into
+ * the managed range is the position modulo its size. @markers holds one
+ * entry per alignment granule, non-zero once the allocation starting there
+ * has been retired, giving its length in granules.
+ */
+struct drm_suballoc_ring {
+	atomic64_t head ____cacheline_aligned_in_smp;
+	atomic64_t tail ____cacheline_aligned_in_smp;
+	spinlock_t lock;
+	u32 markers[];
+};
+
 static void drm_suballoc_remove_locked(struct drm_suballoc *sa);
 static void drm_suballoc_try_free(struct drm_suballoc_manager *sa_manager);
 
@@ -76,12 +100,49 @@ void drm_suballoc_manager_init(struct drm_suballoc_manager *sa_manager,
 	sa_manager->size = size;
 	sa_manager->align = align;
 	sa_manager->hole = &sa_manager->olist;
+	sa_manager->ring = NULL;
 	INIT_LIST_HEAD(&sa_manager->olist);
 	for (i = 0; i < DRM_SUBALLOC_MAX_QUEUES; ++i)
 		INIT_LIST_HEAD(&sa_manager->flist[i]);
 }
 EXPORT_SYMBOL(drm_suballoc_manager_init);
 
+/**
+ * drm_suballoc_manager_init_ring() - Initialise a ring mode drm_suballoc_manager
+ * @sa_manager: pointer to the sa_manager
+ * @size: number of bytes we want to suballocate, a multiple of @align
+ * @align: alignment for each suballocated chunk
+ *
+ * Like drm_suballoc_manager_init(), but allocations are made without taking
+ * the manager lock and are reused in allocation order only, see the
+ * algorithm description at the top of this file.
+ *
+ * Return: 0 on success or a negative error code, in which case the manager
+ * is left initialised in the default mode.
+ */
+int drm_suballoc_manager_init_ring(struct drm_suballoc_manager *sa_manager,
+				   size_t size, size_t align)
+{
+	struct drm_suballoc_ring *ring;
+
+	drm_suballoc_manager_init(sa_manager, size, align);
+
+	if (WARN_ON_ONCE(!size || size % sa_manager->align))
+		return -EINVAL;
+
+	ring = kvzalloc(struct_size(ring, markers, size / sa_manager->align),
+			GFP_KERNEL);
+	if (!ring)
+		return -ENOMEM;
+
+	atomic64_set(&ring->head, 0);
+	atomic64_set(&ring->tail, 0);
+	spin_lock_init(&ring->lock);
+	sa_manager->ring = ring;
+	return 0;
+}
+EXPORT_SYMBOL(drm_suballoc_manager_init_ring);
+
 /**
  * drm_suballoc_manager_fini() - Destroy the drm_suballoc_manager
  * @sa_manager: pointer to the sa_manager
@@ -97,6 +158,19 @@ void drm_suballoc_manager_fini(struct drm_suballoc_manager *sa_manager)
 	if (!sa_manager->size)
 		return;
 
+	if (sa_manager->ring) {
+		struct drm_suballoc_ring *ring = sa_manager->ring;
+
+		/* Pending fence callbacks still point at the markers. */
+		if (atomic64_read(&ring->tail) != atomic64_read(&ring->head))
+			DRM_ERROR("sa_manager is not empty, leaking ring\n");
+		else
+			kvfree(ring);
+		sa_manager->ring = NULL;
+		sa_manager->size = 0;
+		return;
+	}
+
 	if (!list_empty(&sa_manager->olist)) {
 		sa_manager->hole = &sa_manager->olist;
 		drm_suballoc_try_free(sa_manager);
@@ -290,6 +364,166 @@ static bool drm_suballoc_next_hole(struct drm_suballoc_manager *sa_manager,
 	return false;
 }
 
+static size_t drm_suballoc_ring_marker(struct drm_suballoc_manager *sa_manager,
+				       u64 pos)
+{
+	u64 rem;
+
+	div64_u64_rem(pos, sa_manager->size, &rem);
+	return rem / sa_manager->align;
+}
+
+/*
+ * Compute the position after an allocation of @len bytes at @head. If the
+ * allocation would straddle the end of the range, @wrap is set and the
+ * position is the start of the next lap instead: the padding up to there is
+ * committed on its own, so that it never has to fit together with @len.
+ * Return false if that would overrun @tail.
+ */
+static bool drm_suballoc_ring_fits(struct drm_suballoc_manager *sa_manager,
+				   u64 head, u64 tail, size_t len, u64 *next,
+				   bool *wrap)
+{
+	u64 off;
+
+	div64_u64_rem(head, sa_manager->size, &off);
+	*wrap = off + len > sa_manager->size;
+	*next = head + (*wrap ? sa_manager->size - off : len);
+	return *next <= tail + sa_manager->size;
+}
+
+static bool drm_suballoc_ring_event(struct drm_suballoc_manager *sa_manager,
+				    size_t len)
+{
+	struct drm_suballoc_ring *ring = sa_manager->ring;
+	u64 head = atomic64_read(&ring->head);
+	u64 tail = atomic64_read(&ring->tail);
+	u64 next;
+	bool wrap;
+
+	return drm_suballoc_ring_fits(sa_manager, head, tail, len, &next,
+				      &wrap);
+}
+
+/*
+ * Mark @vsize bytes at @vstart as retired and advance the tail over all
+ * retired ranges found at it.
+ */
+static void drm_suballoc_ring_retire_range(struct drm_suballoc_manager *sa_manager,
+					   u64 vstart, u64 vsize)
+{
+	struct drm_suballoc_ring *ring = sa_manager->ring;
+	unsigned long flags;
+	u64 tail;
+	u32 *marker;
+
+	spin_lock_irqsave(&ring->lock, flags);
+	ring->markers[drm_suballoc_ring_marker(sa_manager, vstart)] =
+		vsize / sa_manager->align;
+
+	tail = atomic64_read(&ring->tail);
+	for (;;) {
+		marker = &ring->markers[drm_suballoc_ring_marker(sa_manager,
+								 tail)];
+		if (!*marker)
+			break;
+		tail += (u64)*marker * sa_manager->align;
+		*marker = 0;
+	}
+	atomic64_set(&ring->tail, tail);
+	spin_unlock_irqrestore(&ring->lock, flags);
+
+	/* Pairs with the barrier in the waiter's prepare_to_wait(). */
+	smp_mb();
+	if (waitqueue_active(&sa_manager->wq))
+		wake_up_all(&sa_manager->wq);
+}
+
+static bool drm_suballoc_ring_try_alloc(struct drm_suballoc_manager *sa_manager,
+					struct drm_suballoc *sa,
+					size_t size, size_t len)
+{
+	struct drm_suballoc_ring *ring = sa_manager->ring;
+	u64 head, old, tail, next;
+	bool wrap;
+
+	head = atomic64_read(&ring->head);
+	for (;;) {
+		/*
+		 * The tail never passes the head. If it seems to, the head
+		 * we read is stale and the cmpxchg below fails.
+		 */
+		tail = atomic64_read(&ring->tail);
+		if (!drm_suballoc_ring_fits(sa_manager, head, tail, len, &next,
+					    &wrap))
+			return false;
+
+		old = atomic64_cmpxchg(&ring->head, head, next);
+		if (old != head) {
+			head = old;
+			continue;
+		}
+		if (!wrap)
+			break;
+
+		/*
+		 * We own the padding up to the end of the range, retire it
+		 * right away and retry at the start of the next lap.
+		 */
+		drm_suballoc_ring_retire_range(sa_manager, head, next - head);
+		head = next;
+	}
+
+	sa->vstart = head;
+	sa->vsize = len;
+	div64_u64_rem(head, sa_manager->size, &old);
+	sa->soffset = old;
+	sa->eoffset = sa->soffset + size;
+	return true;
+}
+
+static void drm_suballoc_ring_retire(struct drm_suballoc *sa)
+{
+	u64 vstart = sa->vstart, vsize = sa->vsize;
+	struct drm_suballoc_manager *sa_manager = sa->manager;
+
+	dma_fence_put(sa->fence);
+	kfree(sa);
+
+	drm_suballoc_ring_retire_range(sa_manager, vstart, vsize);
+}
+
+static void drm_suballoc_ring_cb(struct dma_fence *fence,
+				 struct dma_fence_cb *cb)
+{
+	drm_suballoc_ring_retire(container_of(cb, struct drm_suballoc, cb));
+}
+
+static struct drm_suballoc *
+drm_suballoc_ring_new(struct drm_suballoc_manager *sa_manager,
+		      struct drm_suballoc *sa, size_t size, bool intr)
+{
+	size_t len = round_up(size, sa_manager->align);
+	int r;
+
+	while (!drm_suballoc_ring_try_alloc(sa_manager, sa, size, len)) {
+		if (intr) {
+			r = wait_event_interruptible
+				(sa_manager->wq,
+				 drm_suballoc_ring_event(sa_manager, len));
+			if (r) {
+				kfree(sa);
+				return ERR_PTR(r);
+			}
+		} else {
+			wait_event(sa_manager->wq,
+				   drm_suballoc_ring_event(sa_manager, len));
+		}
+	}
+
+	return sa;
+}
+
 /**
  * drm_suballoc_new() - Make a suballocation.
  * @sa_manager: pointer to the sa_manager
@@ -335,6 +569,9 @@ drm_suballoc_new(struct drm_suballoc_manager *sa_manager, size_t size,
 	INIT_LIST_HEAD(&sa->olist);
 	INIT_LIST_HEAD(&sa->flist);
 
+	if (sa_manager->ring)
+		return drm_suballoc_ring_new(sa_manager, sa, size, intr);
+
 	spin_lock(&sa_manager->wq.lock);
 	do {
 		for (i = 0; i < DRM_SUBALLOC_MAX_QUEUES; ++i)
@@ -405,6 +642,17 @@ void drm_suballoc_free(struct drm_suballoc *suballoc,
 
 	sa_manager = suballoc->manager;
 
+	if (sa_manager->ring) {
+		if (fence && !dma_fence_is_signaled(fence)) {
+			suballoc->fence = dma_fence_get(fence);
+			if (!dma_fence_add_callback(fence, &suballoc->cb,
+						    drm_suballoc_ring_cb))
+				return;
+		}
+		drm_suballoc_ring_retire(suballoc);
+		return;
+	}
+
 	spin_lock(&sa_manager->wq.lock);
 	if (fence && !dma_fence_is_signaled(fence)) {
 		u32 idx;
@@ -427,6 +675,21 @@ void drm_suballoc_dump_debug_info(struct drm_suballoc_manager *sa_manager,
 {
 	struct drm_suballoc *i;
 
+	if (sa_manager->ring) {
+		struct drm_suballoc_ring *ring = sa_manager->ring;
+		u64 head = atomic64_read(&ring->head);
+		u64 tail = atomic64_read(&ring->tail);
+		u64 rem;
+
+		div64_u64_rem(tail, sa_manager->size, &rem);
+		drm_printf(p, "ring tail 0x%010llx", suballoc_base + rem);
+		div64_u64_rem(head, sa_manager->size, &rem);
+		drm_printf(p, " head 0x%010llx, %llu of %zu bytes in use\n",
+			   suballoc_base + rem,
+			   (unsigned long long)(head - tail), sa_manager->size);
+		return;
+	}
+
 	spin_lock(&sa_manager->wq.lock);
 	list_for_each_entry(i, &sa_manager->olist, olist) {
 		unsigned long long soffset = i->soffset;
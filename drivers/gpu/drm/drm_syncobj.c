@@ -93,7 +93,9 @@
  * With a timeline syncobj, all manipulation of the synobj's fence happens in
  * terms of a u64 value referring to point in the timeline. See
  * dma_fence_chain_find_seqno() to see how a given point is found in the
- * timeline.
+ * timeline. To avoid walking long chains of unsignaled points, the syncobj
+ * additionally keeps the points of its current chain in an rbtree ordered by
+ * seqno and answers lookups from it whenever it can.
  *
  * Note that applications should be careful to always use timeline set of
  * ioctl() when dealing with syncobj considered as timeline. Using a binary
@@ -204,6 +206,9 @@
 #include <drm/drm.h>
 #include <drm/drm_drv.h>
 #include <drm/drm_file.h>
+#ifdef __FreeBSD__
+#include <drm/drm_freebsd.h>
+#endif
 #include <drm/drm_gem.h>
 #include <drm/drm_print.h>
 #include <drm/drm_syncobj.h>
@@ -264,6 +269,219 @@ struct drm_syncobj *drm_syncobj_find(struct drm_file *file_private,
 }
 EXPORT_SYMBOL(drm_syncobj_find);
 
+/* Drop the whole timeline point index, must be called with the lock held. */
+static void drm_syncobj_points_clear(struct drm_syncobj *syncobj)
+{
+	struct dma_fence_chain *chain, *tmp;
+
+	rbtree_postorder_for_each_entry_safe(chain, tmp, &syncobj->points,
+					     point_node)
+		dma_fence_put(&chain->base);
+	syncobj->points = RB_ROOT;
+	syncobj->points_signaled = 0;
+	syncobj->points_uncovered = 0;
+}
+
+/* Check if everything before the chain node is known to be signaled. */
+static bool drm_syncobj_point_prev_signaled(struct dma_fence_chain *chain)
+{
+	struct dma_fence *prev;
+	bool signaled;
+
+	rcu_read_lock();
+	prev = rcu_dereference(chain->prev);
+	signaled = !prev ||
+		test_bit(DMA_FENCE_FLAG_SIGNALED_BIT, &prev->flags);
+	rcu_read_unlock();
+
+	return signaled;
+}
+
+/*
+ * Drop signaled points from the front of the index. Once a point was
+ * dropped, all points up to it are signaled, so the next one only needs its
+ * own fence to be signaled as well. The newest point is always kept so that
+ * the index can be matched against the syncobj fence.
+ */
+static void drm_syncobj_points_prune(struct drm_syncobj *syncobj)
+{
+	struct rb_node *node;
+
+	while ((node = rb_first(&syncobj->points)) !=
+	       rb_last(&syncobj->points)) {
+		struct dma_fence_chain *chain =
+			rb_entry(node, struct dma_fence_chain, point_node);
+
+		if (!dma_fence_is_signaled(chain->fence))
+			break;
+		if (!syncobj->points_signaled &&
+		    !drm_syncobj_point_prev_signaled(chain))
+			break;
+
+		syncobj->points_signaled = chain->base.seqno;
+		syncobj->points_uncovered = 0;
+		rb_erase(node, &syncobj->points);
+		dma_fence_put(&chain->base);
+	}
+}
+
+/*
+ * Add a new timeline point to the index, must be called with the lock held.
+ * Returns a reference to the oldest indexed point which is still pending, or
+ * NULL if the index doesn't cover the whole chain context.
+ */
+static struct dma_fence *drm_syncobj_points_add(struct drm_syncobj *syncobj,
+						struct dma_fence_chain *chain,
+						struct dma_fence *prev)
+{
+	struct rb_node **link = &syncobj->points.rb_node, *parent = NULL;
+	struct rb_node *last = rb_last(&syncobj->points);
+
+	if (!last ||
+	    &rb_entry(last, struct dma_fence_chain, point_node)->base != prev) {
+		/*
+		 * The index doesn't end at prev, start over. When the chain
+		 * continues an existing context its older points are only
+		 * reachable by walking the chain.
+		 */
+		drm_syncobj_points_clear(syncobj);
+		if (prev && prev->context == chain->base.context)
+			syncobj->points_uncovered = prev->seqno;
+	} else if (prev->context != chain->base.context) {
+		drm_syncobj_points_clear(syncobj);
+	}
+
+	/* Points of one context strictly increase, so always append. */
+	while (*link) {
+		parent = *link;
+		link = &parent->rb_right;
+	}
+	rb_link_node(&chain->point_node, parent, link);
+	rb_insert_color(&chain->point_node, &syncobj->points);
+	dma_fence_get(&chain->base);
+
+	drm_syncobj_points_prune(syncobj);
+
+	if (syncobj->points_uncovered)
+		return NULL;
+
+	chain = rb_entry(rb_first(&syncobj->points), struct dma_fence_chain,
+			 point_node);
+	return dma_fence_get(&chain->base);
+}
+
+/*
+ * Return a reference to the oldest pending point if the index describes the
+ * whole chain context of @fence, NULL otherwise.
+ */
+static struct dma_fence *drm_syncobj_points_oldest(struct drm_syncobj *syncobj,
+						   struct dma_fence *fence)
+{
+	struct dma_fence_chain *chain;
+	struct dma_fence *oldest = NULL;
+	struct rb_node *node;
+
+	spin_lock(&syncobj->lock);
+	node = rb_last(&syncobj->points);
+	if (node &&
+	    &rb_entry(node, struct dma_fence_chain, point_node)->base == fence &&
+	    !syncobj->points_uncovered) {
+		drm_syncobj_points_prune(syncobj);
+		chain = rb_entry(rb_first(&syncobj->points),
+				 struct dma_fence_chain, point_node);
+		oldest = dma_fence_get(&chain->base);
+	}
+	spin_unlock(&syncobj->lock);
+
+	return oldest;
+}
+
+/*
+ * Look up @point in the index with the same semantics as
+ * dma_fence_chain_find_seqno(). Returns false when the index can't answer
+ * for @fence and the chain has to be walked instead.
+ */
+static bool drm_syncobj_points_find_locked(struct drm_syncobj *syncobj,
+					   struct dma_fence **fence,
+					   u64 point, int *ret)
+{
+	struct rb_node *node = rb_last(&syncobj->points), *found = NULL;
+	struct dma_fence_chain *chain;
+
+	if (!node ||
+	    &rb_entry(node, struct dma_fence_chain, point_node)->base != *fence)
+		return false;
+
+	*ret = 0;
+	if (!point)
+		return true;
+
+	if ((*fence)->seqno < point) {
+		*ret = -EINVAL;
+		return true;
+	}
+
+	if (point <= syncobj->points_signaled) {
+		dma_fence_put(*fence);
+		*fence = NULL;
+		return true;
+	}
+
+	if (point <= syncobj->points_uncovered)
+		return false;
+
+	for (node = syncobj->points.rb_node; node;) {
+		chain = rb_entry(node, struct dma_fence_chain, point_node);
+		if (chain->base.seqno >= point) {
+			found = node;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+
+	chain = rb_entry(found, struct dma_fence_chain, point_node);
+	dma_fence_get(&chain->base);
+	dma_fence_put(*fence);
+	*fence = &chain->base;
+	return true;
+}
+
+/*
+ * Replace the referenced syncobj fence in @fence with the one for @point,
+ * see dma_fence_chain_find_seqno(). Must be called with the lock held.
+ */
+static int drm_syncobj_find_point_locked(struct drm_syncobj *syncobj,
+					 struct dma_fence **fence, u64 point)
+{
+	int ret;
+
+	if (drm_syncobj_points_find_locked(syncobj, fence, point, &ret))
+		return ret;
+
+	return dma_fence_chain_find_seqno(fence, point);
+}
+
+/* Same as drm_syncobj_find_point_locked() but takes the lock itself. */
+static int drm_syncobj_find_point(struct drm_syncobj *syncobj,
+				  struct dma_fence **fence, u64 point)
+{
+	bool found;
+	int ret;
+
+	if (!point)
+		return 0;
+
+	spin_lock(&syncobj->lock);
+	found = drm_syncobj_points_find_locked(syncobj, fence, point, &ret);
+	spin_unlock(&syncobj->lock);
+
+	if (found)
+		return ret;
+
+	return dma_fence_chain_find_seqno(fence, point);
+}
+
 static void drm_syncobj_fence_add_wait(struct drm_syncobj *syncobj,
 				       struct syncobj_wait_entry *wait)
 {
@@ -278,7 +496,8 @@ static void drm_syncobj_fence_add_wait(struct drm_syncobj *syncobj,
 	 * callback when a fence has already been set.
 	 */
 	fence = dma_fence_get(rcu_dereference_protected(syncobj->fence, 1));
-	if (!fence || dma_fence_chain_find_seqno(&fence, wait->point)) {
+	if (!fence ||
+	    drm_syncobj_find_point_locked(syncobj, &fence, wait->point)) {
 		dma_fence_put(fence);
 		list_add_tail(&wait->node, &syncobj->cb_list);
 	} else if (!fence) {
@@ -340,7 +559,7 @@ void drm_syncobj_add_point(struct drm_syncobj *syncobj,
 {
 	struct syncobj_wait_entry *wait_cur, *wait_tmp;
 	struct syncobj_eventfd_entry *ev_fd_cur, *ev_fd_tmp;
-	struct dma_fence *prev;
+	struct dma_fence *prev, *oldest;
 
 	dma_fence_get(fence);
 
@@ -351,6 +570,7 @@ void drm_syncobj_add_point(struct drm_syncobj *syncobj,
 	if (prev && prev->seqno >= point)
 		DRM_DEBUG("You are adding an unorder point to timeline!\n");
 	dma_fence_chain_init(chain, prev, fence, point);
+	oldest = drm_syncobj_points_add(syncobj, chain, prev);
 	rcu_assign_pointer(syncobj->fence, &chain->base);
 
 	list_for_each_entry_safe(wait_cur, wait_tmp, &syncobj->cb_list, node)
@@ -361,8 +581,15 @@ void drm_syncobj_add_point(struct drm_syncobj *syncobj,
 #endif
 	spin_unlock(&syncobj->lock);
 
-	/* Walk the chain once to trigger garbage collection */
-	dma_fence_chain_for_each(fence, prev);
+	/*
+	 * Trigger garbage collection of the signaled points. With the index
+	 * covering the chain they all sit behind the oldest pending point, so
+	 * a single step from there is enough instead of walking the chain.
+	 */
+	if (oldest)
+		dma_fence_put(dma_fence_chain_walk(oldest));
+	else
+		dma_fence_chain_for_each(fence, prev);
 	dma_fence_put(prev);
 }
 EXPORT_SYMBOL(drm_syncobj_add_point);
@@ -389,6 +616,7 @@ void drm_syncobj_replace_fence(struct drm_syncobj *syncobj,
 	old_fence = rcu_dereference_protected(syncobj->fence,
 					      lockdep_is_held(&syncobj->lock));
 	rcu_assign_pointer(syncobj->fence, fence);
+	drm_syncobj_points_clear(syncobj);
 
 	if (fence != old_fence) {
 		list_for_each_entry_safe(wait_cur, wait_tmp, &syncobj->cb_list, node)
@@ -425,36 +653,16 @@ static int drm_syncobj_assign_null_handle(struct drm_syncobj *syncobj)
 
 /* 5s default for wait submission */
 #define DRM_SYNCOBJ_WAIT_FOR_SUBMIT_TIMEOUT 5000000000ULL
-/**
- * drm_syncobj_find_fence - lookup and reference the fence in a sync object
- * @file_private: drm file private pointer
- * @handle: sync object handle to lookup.
- * @point: timeline point
- * @flags: DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT or not
- * @fence: out parameter for the fence
- *
- * This is just a convenience function that combines drm_syncobj_find() and
- * drm_syncobj_fence_get().
- *
- * Returns 0 on success or a negative error value on failure. On success @fence
- * contains a reference to the fence, which must be released by calling
- * dma_fence_put().
- */
-int drm_syncobj_find_fence(struct drm_file *file_private,
-			   u32 handle, u64 point, u64 flags,
-			   struct dma_fence **fence)
+
+/* Lookup the fence for @point in an already referenced sync object. */
+static int drm_syncobj_fence_lookup(struct drm_syncobj *syncobj,
+				    u64 point, u64 flags,
+				    struct dma_fence **fence)
 {
-	struct drm_syncobj *syncobj = drm_syncobj_find(file_private, handle);
 	struct syncobj_wait_entry wait;
 	u64 timeout = nsecs_to_jiffies64(DRM_SYNCOBJ_WAIT_FOR_SUBMIT_TIMEOUT);
 	int ret;
 
-	if (flags & ~DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT)
-		return -EINVAL;
-
-	if (!syncobj)
-		return -ENOENT;
-
 	/* Waiting for userspace with locks help is illegal cause that can
 	 * trivial deadlock with page faults for example. Make lockdep complain
 	 * about it early on.
@@ -467,7 +675,7 @@ int drm_syncobj_find_fence(struct drm_file *file_private,
 	*fence = drm_syncobj_fence_get(syncobj);
 
 	if (*fence) {
-		ret = dma_fence_chain_find_seqno(fence, point);
+		ret = drm_syncobj_find_point(syncobj, fence, point);
 		if (!ret) {
 			/* If the requested seqno is already signaled
 			 * drm_syncobj_find_fence may return a NULL
@@ -518,6 +726,39 @@ int drm_syncobj_find_fence(struct drm_file *file_private,
 		drm_syncobj_remove_wait(syncobj, &wait);
 
 out:
+	return ret;
+}
+
+/**
+ * drm_syncobj_find_fence - lookup and reference the fence in a sync object
+ * @file_private: drm file private pointer
+ * @handle: sync object handle to lookup.
+ * @point: timeline point
+ * @flags: DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT or not
+ * @fence: out parameter for the fence
+ *
+ * This is just a convenience function that combines drm_syncobj_find() and
+ * drm_syncobj_fence_get().
+ *
+ * Returns 0 on success or a negative error value on failure. On success @fence
+ * contains a reference to the fence, which must be released by calling
+ * dma_fence_put().
+ */
+int drm_syncobj_find_fence(struct drm_file *file_private,
+			   u32 handle, u64 point, u64 flags,
+			   struct dma_fence **fence)
+{
+	struct drm_syncobj *syncobj;
+	int ret;
+
+	if (flags & ~DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT)
+		return -EINVAL;
+
+	syncobj = drm_syncobj_find(file_private, handle);
+	if (!syncobj)
+		return -ENOENT;
+
+	ret = drm_syncobj_fence_lookup(syncobj, point, flags, fence);
 	drm_syncobj_put(syncobj);
 
 	return ret;
@@ -1033,7 +1274,8 @@ static void syncobj_wait_syncobj_func(struct drm_syncobj *syncobj,
 	fence = rcu_dereference_protected(syncobj->fence,
 					  lockdep_is_held(&syncobj->lock));
 	dma_fence_get(fence);
-	if (!fence || dma_fence_chain_find_seqno(&fence, wait->point)) {
+	if (!fence ||
+	    drm_syncobj_find_point_locked(syncobj, &fence, wait->point)) {
 		dma_fence_put(fence);
 		return;
 	} else if (!fence) {
@@ -1095,7 +1337,8 @@ static signed long drm_syncobj_array_wait_timeout(struct drm_syncobj **syncobjs,
 		entries[i].task = current;
 		entries[i].point = points[i];
 		fence = drm_syncobj_fence_get(syncobjs[i]);
-		if (!fence || dma_fence_chain_find_seqno(&fence, points[i])) {
+		if (!fence ||
+		    drm_syncobj_find_point(syncobjs[i], &fence, points[i])) {
 			dma_fence_put(fence);
 			if (flags & (DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT |
 				     DRM_SYNCOBJ_WAIT_FLAGS_WAIT_AVAILABLE)) {
@@ -1276,12 +1519,39 @@ static int drm_syncobj_array_wait(struct drm_device *dev,
 	return 0;
 }
 
+/*
+ * Resolve and reference an array of handles, taking the handle table lock
+ * only once for the whole array.
+ */
+static int drm_syncobj_array_lookup(struct drm_file *file_private,
+				    const u32 *handles, uint32_t count,
+				    struct drm_syncobj **syncobjs)
+{
+	uint32_t i;
+
+	spin_lock(&file_private->syncobj_table_lock);
+	for (i = 0; i < count; i++) {
+		syncobjs[i] = idr_find(&file_private->syncobj_idr, handles[i]);
+		if (!syncobjs[i])
+			break;
+		drm_syncobj_get(syncobjs[i]);
+	}
+	spin_unlock(&file_private->syncobj_table_lock);
+
+	if (i == count)
+		return 0;
+
+	while (i-- > 0)
+		drm_syncobj_put(syncobjs[i]);
+	return -ENOENT;
+}
+
 static int drm_syncobj_array_find(struct drm_file *file_private,
 				  void __user *user_handles,
 				  uint32_t count_handles,
 				  struct drm_syncobj ***syncobjs_out)
 {
-	uint32_t i, *handles;
+	uint32_t *handles;
 	struct drm_syncobj **syncobjs;
 	int ret;
 
@@ -1301,21 +1571,16 @@ static int drm_syncobj_array_find(struct drm_file *file_private,
 		goto err_free_handles;
 	}
 
-	for (i = 0; i < count_handles; i++) {
-		syncobjs[i] = drm_syncobj_find(file_private, handles[i]);
-		if (!syncobjs[i]) {
-			ret = -ENOENT;
-			goto err_put_syncobjs;
-		}
-	}
+	ret = drm_syncobj_array_lookup(file_private, handles, count_handles,
+				       syncobjs);
+	if (ret)
+		goto err_free_syncobjs;
 
 	kfree(handles);
 	*syncobjs_out = syncobjs;
 	return 0;
 
-err_put_syncobjs:
-	while (i-- > 0)
-		drm_syncobj_put(syncobjs[i]);
+err_free_syncobjs:
 	kfree(syncobjs);
 err_free_handles:
 	kfree(handles);
@@ -1443,7 +1708,7 @@ syncobj_eventfd_entry_func(struct drm_syncobj *syncobj,
 	if (!fence)
 		return;
 
-	ret = dma_fence_chain_find_seqno(&fence, entry->point);
+	ret = drm_syncobj_find_point_locked(syncobj, &fence, entry->point);
 	if (ret != 0) {
 		/* The given seqno has not been submitted yet. */
 		dma_fence_put(fence);
@@ -1667,6 +1932,198 @@ out:
 	return ret;
 }
 
+#ifdef __FreeBSD__
+/*
+ * Resolve the fences of a DRM_SYNCOBJ_OP_TRANSFER operation, everything which
+ * can fail happens here so that applying the operation can't.
+ */
+static int drm_syncobj_op_prepare_transfer(struct drm_syncobj_op *op,
+					   struct drm_syncobj *src,
+					   struct dma_fence **fence,
+					   struct dma_fence_chain **chain)
+{
+	struct dma_fence *tmp;
+	int ret;
+
+	ret = drm_syncobj_fence_lookup(src, op->src_point, op->flags, &tmp);
+	if (ret)
+		return ret;
+
+	if (!op->point) {
+		*fence = tmp;
+		return 0;
+	}
+
+	*fence = dma_fence_unwrap_merge(tmp);
+	dma_fence_put(tmp);
+	if (!*fence)
+		return -ENOMEM;
+
+	*chain = dma_fence_chain_alloc();
+	if (!*chain) {
+		dma_fence_put(*fence);
+		*fence = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+int
+drm_syncobj_batch_ioctl(struct drm_device *dev, void *data,
+			struct drm_file *file_private)
+{
+	struct drm_syncobj_batch *args = data;
+	struct drm_syncobj **syncobjs = NULL;
+	struct dma_fence_chain **chains = NULL;
+	struct dma_fence **fences = NULL;
+	struct drm_syncobj_op *ops;
+	uint32_t i, j, count;
+	u32 *handles;
+	int ret;
+
+	if (!drm_core_check_feature(dev, DRIVER_SYNCOBJ))
+		return -EOPNOTSUPP;
+
+	if (args->flags != 0 || args->pad != 0)
+		return -EINVAL;
+
+	if (args->count_ops == 0)
+		return -EINVAL;
+
+	ops = kmalloc_array(args->count_ops, sizeof(*ops), GFP_KERNEL);
+	if (!ops)
+		return -ENOMEM;
+
+	if (copy_from_user(ops, u64_to_user_ptr(args->ops),
+			   sizeof(*ops) * args->count_ops)) {
+		ret = -EFAULT;
+		goto err_free_ops;
+	}
+
+	/* Every operation has a destination, transfers also have a source. */
+	handles = kmalloc_array(args->count_ops, 2 * sizeof(*handles),
+				GFP_KERNEL);
+	if (!handles) {
+		ret = -ENOMEM;
+		goto err_free_ops;
+	}
+
+	for (i = 0, count = 0; i < args->count_ops; i++) {
+		struct drm_syncobj_op *op = &ops[i];
+
+		ret = -EINVAL;
+		if (op->pad)
+			goto err_free_handles;
+
+		switch (op->op) {
+		case DRM_SYNCOBJ_OP_RESET:
+		case DRM_SYNCOBJ_OP_SIGNAL:
+			if (op->point)
+				goto err_free_handles;
+			fallthrough;
+		case DRM_SYNCOBJ_OP_TIMELINE_SIGNAL:
+			if (op->flags || op->src_handle || op->src_point)
+				goto err_free_handles;
+			break;
+		case DRM_SYNCOBJ_OP_TRANSFER:
+			if (op->flags & ~DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT)
+				goto err_free_handles;
+			break;
+		default:
+			goto err_free_handles;
+		}
+
+		if ((op->op == DRM_SYNCOBJ_OP_TIMELINE_SIGNAL ||
+		     op->op == DRM_SYNCOBJ_OP_TRANSFER) &&
+		    !drm_core_check_feature(dev, DRIVER_SYNCOBJ_TIMELINE)) {
+			ret = -EOPNOTSUPP;
+			goto err_free_handles;
+		}
+
+		handles[count++] = op->handle;
+		if (op->op == DRM_SYNCOBJ_OP_TRANSFER)
+			handles[count++] = op->src_handle;
+	}
+
+	syncobjs = kmalloc_array(count, sizeof(*syncobjs), GFP_KERNEL);
+	fences = kcalloc(args->count_ops, sizeof(*fences), GFP_KERNEL);
+	chains = kcalloc(args->count_ops, sizeof(*chains), GFP_KERNEL);
+	if (!syncobjs || !fences || !chains) {
+		ret = -ENOMEM;
+		goto err_free_arrays;
+	}
+
+	ret = drm_syncobj_array_lookup(file_private, handles, count, syncobjs);
+	if (ret)
+		goto err_free_arrays;
+
+	/* Allocate and resolve everything up front, nothing can fail later. */
+	for (i = 0, j = 0; i < args->count_ops; i++, j++) {
+		struct drm_syncobj_op *op = &ops[i];
+
+		switch (op->op) {
+		case DRM_SYNCOBJ_OP_SIGNAL:
+			fences[i] = dma_fence_allocate_private_stub(ktime_get());
+			if (!fences[i])
+				ret = -ENOMEM;
+			break;
+		case DRM_SYNCOBJ_OP_TIMELINE_SIGNAL:
+			fences[i] = dma_fence_get_stub();
+			/* Point 0 replaces the fence, see below */
+			if (!op->point)
+				break;
+			chains[i] = dma_fence_chain_alloc();
+			if (!chains[i])
+				ret = -ENOMEM;
+			break;
+		case DRM_SYNCOBJ_OP_TRANSFER:
+			ret = drm_syncobj_op_prepare_transfer(op, syncobjs[++j],
+							      &fences[i],
+							      &chains[i]);
+			break;
+		}
+
+		if (ret)
+			goto err_put;
+	}
+
+	for (i = 0, j = 0; i < args->count_ops; i++, j++) {
+		struct drm_syncobj_op *op = &ops[i];
+		struct drm_syncobj *syncobj = syncobjs[j];
+
+		if (op->op == DRM_SYNCOBJ_OP_TRANSFER)
+			j++;
+
+		if (chains[i]) {
+			drm_syncobj_add_point(syncobj, chains[i], fences[i],
+					      op->point);
+			chains[i] = NULL;
+		} else {
+			drm_syncobj_replace_fence(syncobj, fences[i]);
+		}
+	}
+
+err_put:
+	for (i = 0; i < args->count_ops; i++) {
+		dma_fence_put(fences[i]);
+		dma_fence_chain_free(chains[i]);
+	}
+	for (i = 0; i < count; i++)
+		drm_syncobj_put(syncobjs[i]);
+err_free_arrays:
+	kfree(chains);
+	kfree(fences);
+	kfree(syncobjs);
+err_free_handles:
+	kfree(handles);
+err_free_ops:
+	kfree(ops);
+
+	return ret;
+}
+#endif
+
 int drm_syncobj_query_ioctl(struct drm_device *dev, void *data,
 			    struct drm_file *file_private)
 {
@@ -1706,6 +2163,13 @@ int drm_syncobj_query_ioctl(struct drm_device *dev, void *data,
 			if (args->flags &
 			    DRM_SYNCOBJ_QUERY_FLAGS_LAST_SUBMITTED) {
 				point = fence->seqno;
+			} else if ((iter = drm_syncobj_points_oldest(syncobjs[i],
+								     fence))) {
+				dma_fence_put(last_signaled);
+				last_signaled = iter;
+				point = dma_fence_is_signaled(last_signaled) ?
+					last_signaled->seqno :
+					to_dma_fence_chain(last_signaled)->prev_seqno;
 			} else {
 				dma_fence_chain_for_each(iter, fence) {
 					if (iter->context != fence->context) {
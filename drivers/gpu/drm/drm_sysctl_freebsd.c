@@ -31,16 +31,22 @@ __FBSDID("$FreeBSD$");
 
 #include <drm/drm_auth.h>
 #include <drm/drm_drv.h>
+#include <drm/drm_file.h>
+#include <drm/drm_gem.h>
 #include <drm/drm_print.h>
 #include <drm/drm_vblank.h>
 #include <uapi/drm/drm.h>
+#include <uapi/drm/drm_freebsd.h>
 #include "drm_internal.h"
 
+#include <sys/sbuf.h>
 #include <sys/sysctl.h>
 
 
 static int drm_add_busid_modesetting(struct drm_device *dev, struct sysctl_ctx_list *ctx,
 	   struct sysctl_oid *top);
+static int drm_add_vblank_stats(struct drm_device *dev, struct sysctl_ctx_list *ctx,
+	   struct sysctl_oid *top);
 
 SYSCTL_DECL(_hw_drm);
 
@@ -52,6 +58,9 @@ extern unsigned int drm_timestamp_precision;
 static int	   drm_name_info DRM_SYSCTL_HANDLER_ARGS;
 static int	   drm_clients_info DRM_SYSCTL_HANDLER_ARGS;
 static int	   drm_vblank_info DRM_SYSCTL_HANDLER_ARGS;
+static int	   drm_bo_faults_info DRM_SYSCTL_HANDLER_ARGS;
+static int	   drm_fdinfo_info DRM_SYSCTL_HANDLER_ARGS;
+static int	   drm_exec_info DRM_SYSCTL_HANDLER_ARGS;
 
 struct drm_sysctl_list {
 	const char *name;
@@ -60,6 +69,9 @@ struct drm_sysctl_list {
 	{"name",    drm_name_info},
 	{"clients", drm_clients_info},
 	{"vblank",    drm_vblank_info},
+	{"bo_faults", drm_bo_faults_info},
+	{"fdinfo", drm_fdinfo_info},
+	{"exec", drm_exec_info},
 };
 #define DRM_SYSCTL_ENTRIES (sizeof(drm_sysctl_list)/sizeof(drm_sysctl_list[0]))
 
@@ -139,6 +151,7 @@ drm_sysctl_init(struct drm_device *dev)
 #endif
 
 	drm_add_busid_modesetting(dev, &info->ctx, top);
+	drm_add_vblank_stats(dev, &info->ctx, top);
 
 	SYSCTL_ADD_INT(&info->ctx, SYSCTL_CHILDREN(drioid), OID_AUTO,
 	    "vblank_offdelay", CTLFLAG_RW, &drm_vblank_offdelay,
@@ -193,6 +206,67 @@ drm_add_busid_modesetting(struct drm_device *dev, struct sysctl_ctx_list *ctx,
 	return (0);
 }
 
+/*
+ * Binary per-CRTC vblank state for monitoring tools sampling at a high rate,
+ * see struct drm_vblank_crtc_stats. Unlike the "vblank" text dump this takes
+ * no locks, the snapshot is made consistent by the vblank seqlock.
+ */
+static int
+drm_vblank_stats_sysctl(SYSCTL_HANDLER_ARGS)
+{
+	struct drm_device *dev = arg1;
+	struct drm_vblank_crtc *vblank = &dev->vblank[arg2];
+	struct drm_vblank_crtc_stats stats;
+	unsigned int seq;
+	size_t len;
+
+	memset(&stats, 0, sizeof(stats));
+	stats.size = sizeof(stats);
+	do {
+		seq = read_seqbegin(&vblank->seqlock);
+		stats.count = atomic64_read(&vblank->count);
+		stats.time_ns = ktime_to_ns(vblank->time);
+		stats.missed = vblank->missed;
+		stats.queued = vblank->queued;
+	} while (read_seqretry(&vblank->seqlock, seq));
+	stats.enabled = READ_ONCE(vblank->enabled);
+
+	/* Callers built against an older, shorter version get its prefix. */
+	len = sizeof(stats);
+	if (req->oldptr != NULL)
+		len = min(len, req->oldlen);
+
+	return (SYSCTL_OUT(req, &stats, len));
+}
+
+static int
+drm_add_vblank_stats(struct drm_device *dev, struct sysctl_ctx_list *ctx,
+    struct sysctl_oid *top)
+{
+	struct sysctl_oid *node, *oid;
+	char name[8];
+	int i;
+
+	if (dev->vblank == NULL || dev->num_crtcs == 0)
+		return (0);
+
+	node = SYSCTL_ADD_NODE(ctx, SYSCTL_CHILDREN(top), OID_AUTO,
+	    "vblank_stats", CTLFLAG_RD, NULL,
+	    "Per-CRTC struct drm_vblank_crtc_stats");
+	if (node == NULL)
+		return (-ENOMEM);
+
+	for (i = 0; i < dev->num_crtcs; i++) {
+		snprintf(name, sizeof(name), "%d", i);
+		oid = SYSCTL_ADD_PROC(ctx, SYSCTL_CHILDREN(node), OID_AUTO,
+		    name, CTLTYPE_OPAQUE | CTLFLAG_RD | CTLFLAG_MPSAFE, dev, i,
+		    drm_vblank_stats_sysctl, "S,drm_vblank_crtc_stats", NULL);
+		if (oid == NULL)
+			return (-ENOMEM);
+	}
+
+	return (0);
+}
 
 #define DRM_SYSCTL_PRINT(fmt, arg...)				\
 do {								\
@@ -278,6 +352,93 @@ done:
 	return retcode;
 }
 
+static int drm_bo_faults_info DRM_SYSCTL_HANDLER_ARGS
+{
+	struct drm_device *dev = arg1;
+	struct drm_gem_object *obj;
+	struct drm_file *priv;
+	char buf[128];
+	int retcode;
+	int id;
+
+	/* The handle tables are walked under their spinlocks. */
+	retcode = sysctl_wire_old_buffer(req, 0);
+	if (retcode)
+		return retcode;
+
+	mutex_lock(&dev->filelist_mutex);
+	DRM_SYSCTL_PRINT("\n  pid handle       size     faults 2M-prefault\n");
+	list_for_each_entry(priv, &dev->filelist, lhead) {
+		spin_lock(&priv->table_lock);
+		idr_for_each_entry(&priv->object_idr, obj, id) {
+			if (atomic_long_read(&obj->cpu_faults) == 0)
+				continue;
+			snprintf(buf, sizeof(buf), "%5d %6d %10zu %10ld %11ld\n",
+			    priv->pid, id, obj->size,
+			    atomic_long_read(&obj->cpu_faults),
+			    atomic_long_read(&obj->cpu_large_prefaults));
+			retcode = SYSCTL_OUT(req, buf, strlen(buf));
+			if (retcode)
+				break;
+		}
+		spin_unlock(&priv->table_lock);
+		if (retcode)
+			goto done;
+	}
+
+	SYSCTL_OUT(req, "", 1);
+done:
+	mutex_unlock(&dev->filelist_mutex);
+	return retcode;
+}
+
+/*
+ * Per-client usage stats in the fdinfo key/value format of
+ * Documentation/gpu/drm-usage-stats.rst, one blank line separated block per
+ * open file. The driver show_fdinfo hooks may sleep, so the text is built
+ * under filelist_mutex and copied out once the lock is dropped.
+ */
+static int drm_fdinfo_info DRM_SYSCTL_HANDLER_ARGS
+{
+	struct drm_device *dev = arg1;
+	struct drm_file *priv;
+	struct drm_printer p;
+	struct sbuf *sb;
+	int retcode;
+
+	sb = sbuf_new_auto();
+	p = drm_sbuf_printer(sb);
+
+	mutex_lock(&dev->filelist_mutex);
+	list_for_each_entry(priv, &dev->filelist, lhead) {
+		drm_printf(&p, "\npid:\t%d\n", priv->pid);
+		drm_printf(&p, "dev:\t%s\n", devtoname(priv->minor->bsd_device));
+		drm_print_fdinfo(&p, priv);
+	}
+	mutex_unlock(&dev->filelist_mutex);
+
+	retcode = sbuf_finish(sb);
+	if (retcode == 0)
+		retcode = SYSCTL_OUT(req, sbuf_data(sb), sbuf_len(sb) + 1);
+	sbuf_delete(sb);
+	return retcode;
+}
+
+/* Lock contention of the drm_exec contexts, see drm_exec.c. */
+static int drm_exec_info DRM_SYSCTL_HANDLER_ARGS
+{
+	struct drm_device *dev = arg1;
+	char buf[128];
+
+	snprintf(buf, sizeof(buf),
+	    "\ncontended: %lld\nrestarts: %lld\nrestart_ns: %lld\n",
+	    (long long)atomic64_read(&dev->exec_stats.contended),
+	    (long long)atomic64_read(&dev->exec_stats.restarts),
+	    (long long)atomic64_read(&dev->exec_stats.restart_ns));
+
+	return (SYSCTL_OUT(req, buf, strlen(buf) + 1));
+}
+
 static int drm_vblank_info DRM_SYSCTL_HANDLER_ARGS
 {
 	struct drm_device *dev = arg1;
@@ -34,6 +34,8 @@
 
 #include <linux/ktime.h>
 
+#include <drm/drm_trace_ring_freebsd.h>
+
 struct drm_file;
 
 /* TRACE_EVENT(drm_vblank_event, */
@@ -43,6 +45,7 @@ trace_drm_vblank_event(int crtc, unsigned int seq, ktime_t time, bool high_prec)
 {
 	CTR4(KTR_DRM, "drm_vblank_event crtc %d, seq %u, time %lld, "
 	    "high-prec %s", crtc, seq, time, high_prec ? "true" : "false");
+	DRM_TRACE(vblank, DRM_TRACE_VBLANK, crtc, seq, time, high_prec);
 }
 
 /* TRACE_EVENT(drm_vblank_event_queued, */
@@ -52,6 +55,8 @@ trace_drm_vblank_event_queued(struct drm_file *file, int crtc, unsigned int seq)
 {
 	CTR3(KTR_DRM, "drm_vblank_event_queued drm_file %p, crtc %d, seq %u",
 	    file, crtc, seq);
+	DRM_TRACE(vblank__queued, DRM_TRACE_VBLANK_QUEUED, (uintptr_t)file,
+	    crtc, seq, 0);
 }
 
 /* TRACE_EVENT(drm_vblank_event_delivered, */
@@ -60,6 +65,8 @@ static inline void
 trace_drm_vblank_event_delivered(struct drm_file *file, int crtc, unsigned int seq)
 {
 	CTR3(KTR_DRM, "drm_vblank_event_delivered drm_file %p, crtc %d, seq %u", file, crtc, seq);
+	DRM_TRACE(vblank__delivered, DRM_TRACE_VBLANK_DELIVERED,
+	    (uintptr_t)file, crtc, seq, 0);
 }
 
 #endif
@@ -0,0 +1,228 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#include <sys/param.h>
+#include <sys/systm.h>
+#include <sys/kernel.h>
+#include <sys/lock.h>
+#include <sys/malloc.h>
+#include <sys/pcpu.h>
+#include <sys/proc.h>
+#include <sys/sdt.h>
+#include <sys/smp.h>
+#include <sys/sx.h>
+#include <sys/sysctl.h>
+#include <sys/time.h>
+
+#include <machine/atomic.h>
+
+#include <drm/drm_trace_ring_freebsd.h>
+
+SDT_PROVIDER_DEFINE(drm);
+SDT_PROBE_DEFINE4(drm, , , vblank, "int", "uint64_t", "int64_t", "bool");
+SDT_PROBE_DEFINE3(drm, , , vblank__queued, "struct drm_file *", "int",
+    "uint64_t");
+SDT_PROBE_DEFINE3(drm, , , vblank__delivered, "struct drm_file *", "int",
+    "uint64_t");
+SDT_PROBE_DEFINE3(drm, , , job__queued, "struct drm_sched_fence *",
+    "uint64_t", "struct drm_sched_entity *");
+SDT_PROBE_DEFINE3(drm, , , job__run, "struct drm_sched_fence *",
+    "uint64_t", "struct drm_sched_entity *");
+SDT_PROBE_DEFINE1(drm, , , job__done, "struct drm_sched_fence *");
+SDT_PROBE_DEFINE4(drm, , , fence__signal, "struct dma_fence *", "uint64_t",
+    "uint64_t", "int");
+SDT_PROBE_DEFINE4(drm, , , bo__move, "struct ttm_buffer_object *",
+    "size_t", "uint32_t", "uint32_t");
+SDT_PROBE_DEFINE4(drm, , , bo__evict, "struct ttm_buffer_object *",
+    "size_t", "uint32_t", "uint32_t");
+
+static MALLOC_DEFINE(M_DRM_TRACE, "drm_trace", "DRM trace ring");
+
+struct drm_trace_ring {
+	uint64_t head;
+	struct drm_trace_record *records;
+} __aligned(CACHE_LINE_SIZE);
+
+bool drm_trace_ring_active;
+
+/* Rings are allocated on first enable and stay until unload. */
+static struct drm_trace_ring *drm_trace_rings;
+static struct sx drm_trace_lock;
+SX_SYSINIT(drm_trace_lock, &drm_trace_lock, "drm trace");
+
+static u_int drm_trace_ring_size = 4096;
+
+SYSCTL_DECL(_hw_dri);
+static SYSCTL_NODE(_hw_dri, OID_AUTO, trace, CTLFLAG_RW | CTLFLAG_MPSAFE, 0,
+    "DRM event trace");
+SYSCTL_UINT(_hw_dri_trace, OID_AUTO, ring_size, CTLFLAG_RDTUN,
+    &drm_trace_ring_size, 0, "Records per CPU, rounded up to a power of 2");
+
+void
+drm_trace_ring_write(uint32_t type, uint64_t arg0, uint64_t arg1,
+    uint64_t arg2, uint64_t arg3)
+{
+	struct drm_trace_ring *ring;
+	struct drm_trace_record *rec;
+	uint64_t pos;
+
+	/*
+	 * Each CPU only writes its own ring and cannot be preempted while
+	 * doing so, which is all the synchronization writers need.
+	 */
+	critical_enter();
+	ring = &drm_trace_rings[curcpu];
+	pos = ring->head++;
+	rec = &ring->records[pos & (drm_trace_ring_size - 1)];
+	atomic_store_rel_64(&rec->seq, 0);
+	atomic_thread_fence_rel();
+	rec->time_ns = sbttons(sbinuptime());
+	rec->type = type;
+	rec->cpu = curcpu;
+	rec->args[0] = arg0;
+	rec->args[1] = arg1;
+	rec->args[2] = arg2;
+	rec->args[3] = arg3;
+	atomic_store_rel_64(&rec->seq, pos + 1);
+	critical_exit();
+}
+
+static int
+drm_trace_ring_alloc(void)
+{
+	struct drm_trace_ring *rings;
+	int i;
+
+	sx_assert(&drm_trace_lock, SA_XLOCKED);
+
+	if (drm_trace_rings != NULL)
+		return (0);
+
+	drm_trace_ring_size = roundup_pow_of_two(max(drm_trace_ring_size, 2));
+	rings = malloc(sizeof(*rings) * (mp_maxid + 1), M_DRM_TRACE,
+	    M_WAITOK | M_ZERO);
+	CPU_FOREACH(i) {
+		rings[i].records = malloc(sizeof(struct drm_trace_record) *
+		    drm_trace_ring_size, M_DRM_TRACE, M_WAITOK | M_ZERO);
+	}
+	drm_trace_rings = rings;
+
+	return (0);
+}
+
+static void
+drm_trace_ring_free(void *arg __unused)
+{
+	int i;
+
+	if (drm_trace_rings == NULL)
+		return;
+
+	drm_trace_ring_active = false;
+	CPU_FOREACH(i)
+		free(drm_trace_rings[i].records, M_DRM_TRACE);
+	free(drm_trace_rings, M_DRM_TRACE);
+	drm_trace_rings = NULL;
+}
+SYSUNINIT(drm_trace_ring, SI_SUB_DRIVERS, SI_ORDER_ANY,
+    drm_trace_ring_free, NULL);
+
+static int
+drm_trace_enabled_sysctl(SYSCTL_HANDLER_ARGS)
+{
+	int enabled, error;
+
+	enabled = drm_trace_ring_active;
+	error = sysctl_handle_int(oidp, &enabled, 0, req);
+	if (error != 0 || req->newptr == NULL)
+		return (error);
+
+	sx_xlock(&drm_trace_lock);
+	if (enabled)
+		error = drm_trace_ring_alloc();
+	if (error == 0) {
+		atomic_store_rel_char((volatile u_char *)&drm_trace_ring_active,
+		    enabled != 0);
+	}
+	sx_xunlock(&drm_trace_lock);
+
+	return (error);
+}
+SYSCTL_PROC(_hw_dri_trace, OID_AUTO, enabled,
+    CTLTYPE_INT | CTLFLAG_RW | CTLFLAG_MPSAFE, NULL, 0,
+    drm_trace_enabled_sysctl, "I", "Record DRM events into the trace ring");
+
+/*
+ * Return the valid records of all CPU rings, oldest first per CPU. Records
+ * being rewritten concurrently are skipped rather than returned torn.
+ */
+static int
+drm_trace_ring_sysctl(SYSCTL_HANDLER_ARGS)
+{
+	struct drm_trace_record *buf, *rec;
+	struct drm_trace_ring *ring;
+	uint64_t head, pos, seq;
+	u_int n;
+	int error, i;
+
+	sx_slock(&drm_trace_lock);
+	if (drm_trace_rings == NULL) {
+		sx_sunlock(&drm_trace_lock);
+		return (SYSCTL_OUT(req, NULL, 0));
+	}
+
+	buf = malloc(sizeof(*buf) * drm_trace_ring_size, M_DRM_TRACE,
+	    M_WAITOK);
+	error = 0;
+	CPU_FOREACH(i) {
+		ring = &drm_trace_rings[i];
+		head = atomic_load_acq_64(&ring->head);
+		pos = head > drm_trace_ring_size ?
+		    head - drm_trace_ring_size : 0;
+		for (n = 0; pos < head; pos++) {
+			rec = &ring->records[pos & (drm_trace_ring_size - 1)];
+			seq = atomic_load_acq_64(&rec->seq);
+			if (seq != pos + 1)
+				continue;
+			buf[n] = *rec;
+			atomic_thread_fence_acq();
+			if (atomic_load_64(&rec->seq) != seq)
+				continue;
+			buf[n].seq = seq;
+			n++;
+		}
+		error = SYSCTL_OUT(req, buf, sizeof(*buf) * n);
+		if (error != 0)
+			break;
+	}
+	sx_sunlock(&drm_trace_lock);
+	free(buf, M_DRM_TRACE);
+
+	return (error);
+}
+SYSCTL_PROC(_hw_dri_trace, OID_AUTO, ring,
+    CTLTYPE_OPAQUE | CTLFLAG_RD | CTLFLAG_MPSAFE, NULL, 0,
+    drm_trace_ring_sysctl, "S,drm_trace_record",
+    "Recorded DRM events, struct drm_trace_record[]");
@@ -368,6 +368,14 @@ static void drm_update_vblank_count(struct drm_device *dev, unsigned int pipe,
 		    pipe, (unsigned long long)atomic64_read(&vblank->count),
 		    diff, cur_vblank, vblank->last);
 
+#ifdef __FreeBSD__
+	if (in_vblank_irq && diff > 1) {
+		write_seqlock(&vblank->seqlock);
+		vblank->missed += diff - 1;
+		write_sequnlock(&vblank->seqlock);
+	}
+#endif
+
 	if (diff == 0) {
 		drm_WARN_ON_ONCE(dev, cur_vblank != vblank->last);
 		return;
@@ -1035,7 +1043,7 @@ EXPORT_SYMBOL(drm_crtc_next_vblank_start);
 
 static void send_vblank_event(struct drm_device *dev,
 		struct drm_pending_vblank_event *e,
-		u64 seq, ktime_t now)
+		u64 seq, ktime_t now, struct list_head *wake_list)
 {
 	struct timespec64 tv;
 
@@ -1066,7 +1074,10 @@ static void send_vblank_event(struct drm_device *dev,
 	 * retire-fence timestamp to match exactly with HW vsync as it uses it
 	 * for its software vsync modeling.
 	 */
-	drm_send_event_timestamp_locked(dev, &e->base, now);
+	if (wake_list)
+		drm_send_event_batched_locked(dev, &e->base, now, wake_list);
+	else
+		drm_send_event_timestamp_locked(dev, &e->base, now);
 }
 
 /**
@@ -1148,7 +1159,7 @@ void drm_crtc_send_vblank_event(struct drm_crtc *crtc,
 		now = ktime_get();
 	}
 	e->pipe = pipe;
-	send_vblank_event(dev, e, seq, now);
+	send_vblank_event(dev, e, seq, now, NULL);
 }
 EXPORT_SYMBOL(drm_crtc_send_vblank_event);
 
@@ -1395,7 +1406,7 @@ void drm_crtc_vblank_off(struct drm_crtc *crtc)
 			     e->sequence, seq);
 		list_del(&e->base.link);
 		drm_vblank_put(dev, pipe);
-		send_vblank_event(dev, e, seq, now);
+		send_vblank_event(dev, e, seq, now, NULL);
 	}
 
 	/* Cancel any leftover pending vblank work */
@@ -1637,7 +1648,7 @@ static int drm_queue_vblank_event(struct drm_device *dev, unsigned int pipe,
 	e->sequence = req_seq;
 	if (drm_vblank_passed(seq, req_seq)) {
 		drm_vblank_put(dev, pipe);
-		send_vblank_event(dev, e, seq, now);
+		send_vblank_event(dev, e, seq, now, NULL);
 		vblwait->reply.sequence = seq;
 	} else {
 		/* drm_handle_vblank_events will call drm_vblank_put */
@@ -1853,6 +1864,11 @@ static void drm_handle_vblank_events(struct drm_device *dev, unsigned int pipe)
 	struct drm_crtc *crtc = drm_crtc_from_index(dev, pipe);
 	bool high_prec = false;
 	struct drm_pending_vblank_event *e, *t;
+	LIST_HEAD(wake_list);
+#ifdef __FreeBSD__
+	struct drm_vblank_crtc *vblank = drm_vblank_crtc(dev, pipe);
+	u32 queued = 0;
+#endif
 	ktime_t now;
 	u64 seq;
 
@@ -1863,16 +1879,31 @@ static void drm_handle_vblank_events(struct drm_device *dev, unsigned int pipe)
 	list_for_each_entry_safe(e, t, &dev->vblank_event_list, base.link) {
 		if (e->pipe != pipe)
 			continue;
-		if (!drm_vblank_passed(seq, e->sequence))
+		if (!drm_vblank_passed(seq, e->sequence)) {
+#ifdef __FreeBSD__
+			queued++;
+#endif
 			continue;
+		}
 
 		drm_dbg_core(dev, "vblank event on %llu, current %llu\n",
 			     e->sequence, seq);
 
 		list_del(&e->base.link);
 		drm_vblank_put(dev, pipe);
-		send_vblank_event(dev, e, seq, now);
+		send_vblank_event(dev, e, seq, now, &wake_list);
+	}
+
+	/* One wakeup per file for all events of this vblank. */
+	drm_send_event_batch_wake(dev, &wake_list);
+
+#ifdef __FreeBSD__
+	if (vblank->queued != queued) {
+		write_seqlock(&vblank->seqlock);
+		vblank->queued = queued;
+		write_sequnlock(&vblank->seqlock);
 	}
+#endif
 
 	if (crtc && crtc->funcs->get_vblank_timestamp)
 		high_prec = true;
@@ -2117,7 +2148,7 @@ int drm_crtc_queue_sequence_ioctl(struct drm_device *dev, void *data,
 
 	if (drm_vblank_passed(seq, req_seq)) {
 		drm_crtc_vblank_put(crtc);
-		send_vblank_event(dev, e, seq, now);
+		send_vblank_event(dev, e, seq, now, NULL);
 		queue_seq->sequence = seq;
 	} else {
 		/* drm_handle_vblank_events will call drm_vblank_put */
@@ -244,18 +244,25 @@ static int vma_node_allow(struct drm_vma_offset_node *node,
 			  struct drm_file *tag, bool ref_counted)
 {
 	struct rb_node **iter;
-	struct rb_node *parent = NULL;
-	struct drm_vma_offset_file *new, *entry;
-	int ret = 0;
-
-	/* Preallocate entry to avoid atomic allocations below. It is quite
-	 * unlikely that an open-file is added twice to a single node so we
-	 * don't optimize for this case. OOM is checked below only if the entry
-	 * is actually used. */
-	new = kmalloc(sizeof(*entry), GFP_KERNEL);
+	struct rb_node *parent;
+	struct drm_vma_offset_file *new = NULL, *entry;
+	int i, free_slot, ret = 0;
 
 	write_lock(&node->vm_lock);
 
+retry:
+	free_slot = -1;
+	for (i = 0; i < DRM_VMA_NODE_INLINE_FILES; i++) {
+		if (node->vm_inline_tags[i] == tag) {
+			if (ref_counted)
+				node->vm_inline_count[i]++;
+			goto unlock;
+		} else if (!node->vm_inline_tags[i] && free_slot < 0) {
+			free_slot = i;
+		}
+	}
+
+	parent = NULL;
 	iter = &node->vm_files.rb_node;
 
 	while (likely(*iter)) {
@@ -273,11 +280,23 @@ static int vma_node_allow(struct drm_vma_offset_node *node,
 		}
 	}
 
-	if (!new) {
-		ret = -ENOMEM;
+	if (free_slot >= 0) {
+		node->vm_inline_count[free_slot] = 1;
+		WRITE_ONCE(node->vm_inline_tags[free_slot], tag);
 		goto unlock;
 	}
 
+	/* Only allocate once the inline slots are exhausted, then look again
+	 * as the node may have changed while the lock was dropped. */
+	if (!new) {
+		write_unlock(&node->vm_lock);
+		new = kmalloc(sizeof(*entry), GFP_KERNEL);
+		if (!new)
+			return -ENOMEM;
+		write_lock(&node->vm_lock);
+		goto retry;
+	}
+
 	new->vm_tag = tag;
 	new->vm_count = 1;
 	rb_link_node(&new->vm_rb, parent, iter);
@@ -359,9 +378,18 @@ void drm_vma_node_revoke(struct drm_vma_offset_node *node,
 {
 	struct drm_vma_offset_file *entry;
 	struct rb_node *iter;
+	int i;
 
 	write_lock(&node->vm_lock);
 
+	for (i = 0; i < DRM_VMA_NODE_INLINE_FILES; i++) {
+		if (node->vm_inline_tags[i] == tag) {
+			if (!--node->vm_inline_count[i])
+				WRITE_ONCE(node->vm_inline_tags[i], NULL);
+			goto unlock;
+		}
+	}
+
 	iter = node->vm_files.rb_node;
 	while (likely(iter)) {
 		entry = rb_entry(iter, struct drm_vma_offset_file, vm_rb);
@@ -378,6 +406,7 @@ void drm_vma_node_revoke(struct drm_vma_offset_node *node,
 		}
 	}
 
+unlock:
 	write_unlock(&node->vm_lock);
 }
 EXPORT_SYMBOL(drm_vma_node_revoke);
@@ -390,7 +419,8 @@ EXPORT_SYMBOL(drm_vma_node_revoke);
  * Search the list in @node whether @tag is currently on the list of allowed
  * open-files (see drm_vma_node_allow()).
  *
- * This is locked against concurrent access internally.
+ * This is locked against concurrent access internally. Files kept inline in
+ * @node are found without taking the lock.
  *
  * RETURNS:
  * true if @filp is on the list
@@ -400,6 +430,20 @@ bool drm_vma_node_is_allowed(struct drm_vma_offset_node *node,
 {
 	struct drm_vma_offset_file *entry;
 	struct rb_node *iter;
+	int i;
+
+	if (unlikely(!tag))
+		return false;
+
+	/* Tags are only compared, never dereferenced, so a racy read is as
+	 * good as one under the lock. */
+	for (i = 0; i < DRM_VMA_NODE_INLINE_FILES; i++) {
+		if (READ_ONCE(node->vm_inline_tags[i]) == tag)
+			return true;
+	}
+
+	if (!READ_ONCE(node->vm_files.rb_node))
+		return false;
 
 	read_lock(&node->vm_lock);
 
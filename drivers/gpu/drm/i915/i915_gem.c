@@ -1114,6 +1114,7 @@ void i915_gem_drain_freed_objects(struct drm_i915_private *i915)
 {
 	while (atomic_read(&i915->mm.free_count)) {
 		flush_work(&i915->mm.free_work);
+		ttm_device_flush_delayed(&i915->bdev);
 		drain_workqueue(i915->bdev.wq);
 		rcu_barrier();
 	}
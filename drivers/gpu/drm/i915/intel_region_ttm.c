@@ -136,6 +136,7 @@ int intel_region_ttm_fini(struct intel_memory_region *mem)
 			break;
 
 		msleep(20);
+		ttm_device_flush_delayed(&mem->i915->bdev);
 		drain_workqueue(mem->i915->bdev.wq);
 	}
 
@@ -26,14 +26,22 @@
 
 #ifdef __FreeBSD__
 
+#include <drm/drm_trace_ring_freebsd.h>
+
 static inline void
-trace_drm_sched_job(void *sched_job, void *entity) {
+trace_drm_sched_job(struct drm_sched_job *sched_job,
+    struct drm_sched_entity *entity) {
 	CTR2(KTR_DRM, "drm_sched_job %p, entity %p", sched_job, entity);
+	DRM_TRACE(job__queued, DRM_TRACE_JOB_QUEUED,
+	    (uintptr_t)sched_job->s_fence, sched_job->id, (uintptr_t)entity, 0);
 }
 
 static inline void
-trace_drm_run_job(void *sched_job, void *entity) {
+trace_drm_run_job(struct drm_sched_job *sched_job,
+    struct drm_sched_entity *entity) {
 	CTR2(KTR_DRM, "drm_sched_job %p, entity %p", sched_job, entity);
+	DRM_TRACE(job__run, DRM_TRACE_JOB_RUN,
+	    (uintptr_t)sched_job->s_fence, sched_job->id, (uintptr_t)entity, 0);
 }
 
 static inline void
@@ -42,8 +50,9 @@ trace_drm_sched_job_wait_dep(struct drm_sched_job *job, struct dma_fence *fence)
 }
 
 static inline void
-trace_drm_sched_process_job(void *s_fence) {
+trace_drm_sched_process_job(struct drm_sched_fence *s_fence) {
 	CTR1(KTR_DRM, "drm_process_sched_job %p", s_fence);
+	DRM_TRACE(job__done, DRM_TRACE_JOB_DONE, (uintptr_t)s_fence, 0, 0, 0);
 }
 
 #else
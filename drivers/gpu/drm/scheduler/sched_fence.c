@@ -28,6 +28,9 @@
 #include <linux/wait.h>
 
 #include <drm/gpu_scheduler.h>
+#ifdef __FreeBSD__
+#include <drm/drm_trace_ring_freebsd.h>
+#endif
 
 static struct kmem_cache *sched_fence_slab;
 
@@ -80,6 +83,11 @@ void drm_sched_fence_finished(struct drm_sched_fence *fence, int result)
 	if (result)
 		dma_fence_set_error(&fence->finished, result);
 	dma_fence_signal(&fence->finished);
+#ifdef __FreeBSD__
+	DRM_TRACE(fence__signal, DRM_TRACE_FENCE_SIGNAL,
+	    (uintptr_t)&fence->finished, fence->finished.context,
+	    fence->finished.seqno, result);
+#endif
 }
 
 static const char *drm_sched_fence_get_driver_name(struct dma_fence *fence)
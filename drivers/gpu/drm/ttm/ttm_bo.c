@@ -46,6 +46,10 @@
 
 #include "ttm_module.h"
 
+#ifdef __FreeBSD__
+#include <drm/drm_trace_ring_freebsd.h>
+#endif
+
 static void ttm_bo_mem_space_debug(struct ttm_buffer_object *bo,
 					struct ttm_placement *placement)
 {
@@ -119,8 +123,15 @@ static int ttm_bo_handle_move_mem(struct ttm_buffer_object *bo,
 {
 	struct ttm_device *bdev = bo->bdev;
 	bool old_use_tt, new_use_tt;
+#ifdef __FreeBSD__
+	uint32_t old_mem_type, new_mem_type;
+#endif
 	int ret;
 
+#ifdef __FreeBSD__
+	old_mem_type = bo->resource ? bo->resource->mem_type : TTM_PL_SYSTEM;
+	new_mem_type = mem->mem_type;
+#endif
 	old_use_tt = !bo->resource || ttm_manager_type(bdev, bo->resource->mem_type)->use_tt;
 	new_use_tt = ttm_manager_type(bdev, mem->mem_type)->use_tt;
 
@@ -157,6 +168,14 @@ static int ttm_bo_handle_move_mem(struct ttm_buffer_object *bo,
 	}
 
 	ctx->bytes_moved += bo->base.size;
+#ifdef __FreeBSD__
+	if (evict)
+		DRM_TRACE(bo__evict, DRM_TRACE_BO_EVICT, (uintptr_t)bo,
+		    bo->base.size, old_mem_type, new_mem_type);
+	else
+		DRM_TRACE(bo__move, DRM_TRACE_BO_MOVE, (uintptr_t)bo,
+		    bo->base.size, old_mem_type, new_mem_type);
+#endif
 	return 0;
 
 out_err:
@@ -298,24 +317,152 @@ static int ttm_bo_cleanup_refs(struct ttm_buffer_object *bo,
 	return 0;
 }
 
+static void ttm_bo_delayed_cb(struct dma_fence *fence,
+			      struct dma_fence_cb *cb)
+{
+	struct ttm_buffer_object *bo =
+	    container_of(cb, struct ttm_buffer_object, delayed_cb);
+	struct ttm_device *bdev = bo->bdev;
+
+	queue_work_node(bdev->pool.nid, bdev->wq, &bdev->delayed_work);
+}
+
+static void ttm_bo_delayed_disarm(struct ttm_buffer_object *bo)
+{
+	if (!bo->delayed_fence)
+		return;
+
+	dma_fence_remove_callback(bo->delayed_fence, &bo->delayed_cb);
+	dma_fence_put(bo->delayed_fence);
+	bo->delayed_fence = NULL;
+}
+
 /*
- * Block for the dma_resv object to become idle, lock the buffer and clean up
- * the resource and tt object.
+ * Arm the callback on an unsignaled fence of the BO, return false if there
+ * is none left.
  */
-static void ttm_bo_delayed_delete(struct work_struct *work)
+static bool ttm_bo_delayed_arm(struct ttm_buffer_object *bo)
 {
-	struct ttm_buffer_object *bo;
+	struct dma_resv_iter cursor;
+	struct dma_fence *fence;
+	bool armed = false;
 
-	bo = container_of(work, typeof(*bo), delayed_delete);
+	dma_resv_iter_begin(&cursor, bo->base.resv, DMA_RESV_USAGE_BOOKKEEP);
+	dma_resv_for_each_fence_unlocked(&cursor, fence) {
+		if (dma_fence_is_signaled(fence))
+			continue;
+
+		dma_fence_get(fence);
+		if (!dma_fence_add_callback(fence, &bo->delayed_cb,
+					    ttm_bo_delayed_cb)) {
+			bo->delayed_fence = fence;
+			armed = true;
+			break;
+		}
+		dma_fence_put(fence);
+	}
+	dma_resv_iter_end(&cursor);
+
+	return armed;
+}
 
-	dma_resv_wait_timeout(bo->base.resv, DMA_RESV_USAGE_BOOKKEEP, false,
-			      MAX_SCHEDULE_TIMEOUT);
+/*
+ * Lock the buffer, clean up the resource and tt object and drop the reference
+ * the delayed destroy list held.
+ */
+static void ttm_bo_delayed_destroy(struct ttm_buffer_object *bo)
+{
+	list_del_init(&bo->delayed_entry);
+	ttm_bo_delayed_disarm(bo);
 	dma_resv_lock(bo->base.resv, NULL);
 	ttm_bo_cleanup_memtype_use(bo);
 	dma_resv_unlock(bo->base.resv);
 	ttm_bo_put(bo);
 }
 
+/*
+ * Destroy all idle BOs on the delayed list in one go. When a client exits
+ * with many BOs this replaces a work item and a blocking wait per BO.
+ *
+ * The work never blocks on a busy BO, which would hold back the release of
+ * every BO freed after it. Busy BOs instead stay on the list with a callback
+ * armed on one of their unsignaled fences, which runs the work again.
+ */
+void ttm_bo_delayed_delete(struct work_struct *work)
+{
+	struct ttm_device *bdev =
+	    container_of(work, struct ttm_device, delayed_work);
+	struct ttm_buffer_object *bo, *next;
+	LIST_HEAD(list);
+
+	spin_lock(&bdev->lru_lock);
+	/* ttm_bo_delayed_flush() owns the list until it is done */
+	if (!bdev->delayed_flushing)
+		list_splice_init(&bdev->delayed, &list);
+	spin_unlock(&bdev->lru_lock);
+
+	list_for_each_entry_safe(bo, next, &list, delayed_entry) {
+		if (dma_resv_test_signaled(bo->base.resv,
+					   DMA_RESV_USAGE_BOOKKEEP)) {
+			ttm_bo_delayed_destroy(bo);
+			continue;
+		}
+
+		/* Still waiting for a fence which hasn't signaled yet */
+		if (bo->delayed_fence &&
+		    !dma_fence_is_signaled(bo->delayed_fence))
+			continue;
+
+		ttm_bo_delayed_disarm(bo);
+		if (!ttm_bo_delayed_arm(bo))
+			ttm_bo_delayed_destroy(bo);
+	}
+
+	spin_lock(&bdev->lru_lock);
+	list_splice(&list, &bdev->delayed);
+	spin_unlock(&bdev->lru_lock);
+}
+
+/*
+ * Wait for and destroy every BO on the delayed list, including the busy ones
+ * the work left parked there with a fence callback armed. Draining the work
+ * queue alone doesn't do that, a callback can still queue the work later.
+ */
+void ttm_bo_delayed_flush(struct ttm_device *bdev)
+{
+	struct ttm_buffer_object *bo, *next;
+	LIST_HEAD(list);
+
+	spin_lock(&bdev->lru_lock);
+	bdev->delayed_flushing = true;
+	spin_unlock(&bdev->lru_lock);
+
+	/* Let a running work put the BOs it spliced back on the list */
+	cancel_work_sync(&bdev->delayed_work);
+
+	/* Destroying a BO can release others, so loop until none is left */
+	for (;;) {
+		spin_lock(&bdev->lru_lock);
+		list_splice_init(&bdev->delayed, &list);
+		spin_unlock(&bdev->lru_lock);
+
+		if (list_empty(&list))
+			break;
+
+		list_for_each_entry_safe(bo, next, &list, delayed_entry) {
+			ttm_bo_delayed_disarm(bo);
+			dma_resv_wait_timeout(bo->base.resv,
+					      DMA_RESV_USAGE_BOOKKEEP, false,
+					      MAX_SCHEDULE_TIMEOUT);
+			ttm_bo_delayed_destroy(bo);
+		}
+	}
+
+	spin_lock(&bdev->lru_lock);
+	bdev->delayed_flushing = false;
+	spin_unlock(&bdev->lru_lock);
+}
+
 static void ttm_bo_release(struct kref *kref)
 {
 	struct ttm_buffer_object *bo =
@@ -368,16 +515,17 @@ static void ttm_bo_release(struct kref *kref)
 			}
 
 			kref_init(&bo->kref);
+			bo->delayed_fence = NULL;
+			list_add_tail(&bo->delayed_entry, &bdev->delayed);
 			spin_unlock(&bo->bdev->lru_lock);
 
-			INIT_WORK(&bo->delayed_delete, ttm_bo_delayed_delete);
-
 			/* Schedule the worker on the closest NUMA node. This
 			 * improves performance since system memory might be
 			 * cleared on free and that is best done on a CPU core
 			 * close to it.
 			 */
-			queue_work_node(bdev->pool.nid, bdev->wq, &bo->delayed_delete);
+			queue_work_node(bdev->pool.nid, bdev->wq,
+					&bdev->delayed_work);
 			return;
 		}
 
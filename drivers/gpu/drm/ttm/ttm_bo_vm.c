@@ -37,6 +37,11 @@
 
 #include <drm/drm_drv.h>
 #include <drm/drm_managed.h>
+#ifdef __FreeBSD__
+#include <sys/counter.h>
+#include <sys/sysctl.h>
+#include <drm/ttm/ttm_sysctl_freebsd.h>
+#endif
 
 static vm_fault_t ttm_bo_vm_fault_idle(struct ttm_buffer_object *bo,
 				struct vm_fault *vmf)
@@ -160,6 +165,110 @@ vm_fault_t ttm_bo_vm_reserve(struct ttm_buffer_object *bo,
 }
 EXPORT_SYMBOL(ttm_bo_vm_reserve);
 
+#if defined(__FreeBSD__)
+static unsigned int ttm_bo_vm_prefault_max = 512;
+SYSCTL_UINT(_hw_ttm, OID_AUTO, prefault_max, CTLFLAG_RWTUN,
+    &ttm_bo_vm_prefault_max, 0,
+    "Upper bound of the adaptive page fault prefault window in pages");
+
+static COUNTER_U64_DEFINE_EARLY(ttm_bo_vm_faults);
+SYSCTL_COUNTER_U64(_hw_ttm, OID_AUTO, faults, CTLFLAG_RD,
+    &ttm_bo_vm_faults, "CPU page faults on buffer objects");
+static COUNTER_U64_DEFINE_EARLY(ttm_bo_vm_faults_sequential);
+SYSCTL_COUNTER_U64(_hw_ttm, OID_AUTO, faults_sequential, CTLFLAG_RD,
+    &ttm_bo_vm_faults_sequential,
+    "CPU page faults right behind the previous prefault window");
+static COUNTER_U64_DEFINE_EARLY(ttm_bo_vm_pages_inserted);
+SYSCTL_COUNTER_U64(_hw_ttm, OID_AUTO, fault_pages_inserted, CTLFLAG_RD,
+    &ttm_bo_vm_pages_inserted, "Pages inserted by CPU page faults");
+
+/*
+ * Adapt the prefault window to the access pattern. A fault right behind the
+ * previous window doubles it, any other fault halves it, bounded by one page
+ * and hw.ttm.prefault_max. The caller's @num_prefault is the starting size.
+ */
+static pgoff_t ttm_bo_vm_prefault_window(struct ttm_buffer_object *bo,
+					 unsigned long page_offset,
+					 pgoff_t num_prefault)
+{
+	unsigned int window;
+
+	if (num_prefault <= 1)
+		return num_prefault;
+
+	if (bo->fault_window == 0) {
+		window = num_prefault;
+	} else if (page_offset == bo->fault_next) {
+		counter_u64_add(ttm_bo_vm_faults_sequential, 1);
+		window = bo->fault_window * 2;
+	} else {
+		window = bo->fault_window / 2;
+	}
+
+	window = clamp(window, 1U, max(READ_ONCE(ttm_bo_vm_prefault_max), 1U));
+	bo->fault_window = window;
+	return window;
+}
+
+/*
+ * Check whether the pagesizes[1] (2 MiB on amd64) aligned range around
+ * @address is backed by physically contiguous memory with the same
+ * alignment. If so, move @address and @page_offset to its start, so that
+ * the whole range is prefaulted in one go.
+ *
+ * This only enters the range's 4K PTEs up front, it doesn't create a
+ * superpage mapping. TTM pool pages aren't allocated from superpage
+ * reservations and aperture pages are fictitious, so pmap can't promote
+ * either. Entering a real psind 1 mapping is left for later.
+ */
+static bool ttm_bo_vm_large_prefault(struct ttm_buffer_object *bo,
+				struct vm_area_struct *vma,
+				unsigned long *address,
+				unsigned long *page_offset,
+				unsigned long page_last)
+{
+	unsigned long start, offset, npages, pfn, first_pfn = 0;
+	struct page *page;
+	pgoff_t i;
+
+	if (pagesizes[1] == 0)
+		return false;
+
+	npages = pagesizes[1] >> PAGE_SHIFT;
+	start = rounddown2(*address, pagesizes[1]);
+	if (start < vma->vm_start || start + pagesizes[1] > vma->vm_end)
+		return false;
+
+	offset = *page_offset - ((*address - start) >> PAGE_SHIFT);
+	if (offset + npages > page_last ||
+	    offset + npages > PFN_UP(bo->base.size))
+		return false;
+
+	for (i = 0; i < npages; i++) {
+		if (bo->resource->bus.is_iomem) {
+			pfn = ttm_bo_io_mem_pfn(bo, offset + i);
+		} else {
+			page = bo->ttm->pages[offset + i];
+			if (!page)
+				return false;
+			pfn = page_to_pfn(page);
+		}
+
+		if (i == 0) {
+			if ((pfn & (npages - 1)) != 0)
+				return false;
+			first_pfn = pfn;
+		} else if (pfn != first_pfn + i) {
+			return false;
+		}
+	}
+
+	*address = start;
+	*page_offset = offset;
+	return true;
+}
+#endif
+
 /**
  * ttm_bo_vm_fault_reserved - TTM fault helper
  * @vmf: The struct vm_fault given as argument to the fault callback
@@ -170,7 +279,9 @@ EXPORT_SYMBOL(ttm_bo_vm_reserve);
  *
  * This function inserts one or more page table entries pointing to the
  * memory backing the buffer object, and then returns a return code
- * instructing the caller to retry the page access.
+ * instructing the caller to retry the page access. On FreeBSD the whole
+ * aligned pagesizes[1] range is prefaulted instead when its backing memory
+ * is contiguous.
  *
  * Return:
  *   VM_FAULT_NOPAGE on success or pending signal
@@ -238,6 +349,20 @@ vm_fault_t ttm_bo_vm_fault_reserved(struct vm_fault *vmf,
 		prot = pgprot_decrypted(prot);
 	}
 
+#if defined(__FreeBSD__)
+	counter_u64_add(ttm_bo_vm_faults, 1);
+	atomic_long_inc(&bo->base.cpu_faults);
+	num_prefault = ttm_bo_vm_prefault_window(bo, page_offset, num_prefault);
+	if (num_prefault > 1 &&
+	    ttm_bo_vm_large_prefault(bo, vma, &address, &page_offset,
+				     page_last)) {
+		atomic_long_inc(&bo->base.cpu_large_prefaults);
+		num_prefault = max_t(pgoff_t, num_prefault,
+				     pagesizes[1] >> PAGE_SHIFT);
+	}
+	bo->fault_next = page_offset + num_prefault;
+#endif
+
 	/*
 	 * Speculatively prefault a number of pages. Only error on
 	 * first page.
@@ -292,6 +417,9 @@ vm_fault_t ttm_bo_vm_fault_reserved(struct vm_fault *vmf,
 			} else
 				break;
 		}
+#if defined(__FreeBSD__)
+		counter_u64_add(ttm_bo_vm_pages_inserted, 1);
+#endif
 
 		address += PAGE_SIZE;
 		if (unlikely(++page_offset >= page_last))
@@ -237,6 +237,9 @@ int ttm_device_init(struct ttm_device *bdev, const struct ttm_device_funcs *func
 	bdev->vma_manager = vma_manager;
 	spin_lock_init(&bdev->lru_lock);
 	INIT_LIST_HEAD(&bdev->pinned);
+	INIT_LIST_HEAD(&bdev->delayed);
+	INIT_WORK(&bdev->delayed_work, ttm_bo_delayed_delete);
+	bdev->delayed_flushing = false;
 #ifdef __linux__
 	bdev->dev_mapping = mapping;
 #endif
@@ -257,6 +260,7 @@ void ttm_device_fini(struct ttm_device *bdev)
 	list_del(&bdev->device_list);
 	mutex_unlock(&ttm_global_mutex);
 
+	ttm_device_flush_delayed(bdev);
 	drain_workqueue(bdev->wq);
 	destroy_workqueue(bdev->wq);
 
@@ -275,6 +279,21 @@ void ttm_device_fini(struct ttm_device *bdev)
 }
 EXPORT_SYMBOL(ttm_device_fini);
 
+/**
+ * ttm_device_flush_delayed - destroy all BOs waiting for delayed delete
+ * @bdev: the device
+ *
+ * Busy BOs released to the delayed delete work stay on &ttm_device.delayed
+ * until their fences signal, so draining &ttm_device.wq doesn't destroy them.
+ * This waits for their fences and destroys them. Call it before draining the
+ * work queue when all released BOs must be gone afterwards.
+ */
+void ttm_device_flush_delayed(struct ttm_device *bdev)
+{
+	ttm_bo_delayed_flush(bdev);
+}
+EXPORT_SYMBOL(ttm_device_flush_delayed);
+
 static void ttm_device_clear_lru_dma_mappings(struct ttm_device *bdev,
 					      struct list_head *list)
 {
@@ -35,9 +35,12 @@
 
 struct dentry;
 struct ttm_device;
+struct work_struct;
 
 extern struct dentry *ttm_debugfs_root;
 
 void ttm_sys_man_init(struct ttm_device *bdev);
+void ttm_bo_delayed_delete(struct work_struct *work);
+void ttm_bo_delayed_flush(struct ttm_device *bdev);
 
 #endif /* _TTM_MODULE_H_ */
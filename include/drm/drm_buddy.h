@@ -10,6 +10,7 @@
 #include <linux/list.h>
 #include <linux/slab.h>
 #include <linux/sched.h>
+#include <linux/spinlock.h>
 
 #include <drm/drm_print.h>
 
@@ -67,8 +68,12 @@ struct drm_buddy_block {
  * drm_buddy_alloc* and drm_buddy_free* should suffice.
  */
 struct drm_buddy {
-	/* Maintain a free list for each order. */
+	/*
+	 * Maintain free lists for each order, split by clear state so that
+	 * cleared and dirty requests find a matching block without scanning.
+	 */
 	struct list_head *free_list;
+	struct list_head *clear_free_list;
 
 	/*
 	 * Maintain explicit binary tree(s) to track the allocation of the
@@ -93,6 +98,41 @@ struct drm_buddy {
 	u64 clear_avail;
 };
 
+/*
+ * Optional per-CPU caches ("magazines") of allocated blocks for the
+ * smallest orders, so that high rate small allocations don't serialize on
+ * the lock protecting the buddy.
+ *
+ * drm_buddy_cache_get() and drm_buddy_cache_put() only take the magazine
+ * spinlock. drm_buddy_cache_refill(), drm_buddy_cache_trim() and
+ * drm_buddy_cache_drain() move blocks between the magazines and the buddy
+ * and must be called with the user's buddy lock held. Cached blocks stay
+ * allocated from the buddy's point of view, are always dirty and have their
+ * private pointer cleared.
+ */
+#define DRM_BUDDY_CACHE_ORDERS	5	/* chunk_size << 0 ... chunk_size << 4 */
+#define DRM_BUDDY_CACHE_SIZE	16
+#define DRM_BUDDY_CACHE_BATCH	(DRM_BUDDY_CACHE_SIZE / 2)
+
+struct drm_buddy_magazine {
+	spinlock_t lock;
+	unsigned int count[DRM_BUDDY_CACHE_ORDERS];
+	struct drm_buddy_block *blocks[DRM_BUDDY_CACHE_ORDERS][DRM_BUDDY_CACHE_SIZE];
+} ____cacheline_aligned_in_smp;
+
+struct drm_buddy_cache {
+	struct drm_buddy *mm;
+	struct drm_buddy_magazine *mags;
+	unsigned int nr_mags;
+	bool disabled;
+
+	/* Statistics, how often the buddy lock could be avoided. */
+	atomic64_t hits;
+	atomic64_t refills;
+	atomic64_t frees;
+	atomic64_t trims;
+};
+
 static inline u64
 drm_buddy_block_offset(struct drm_buddy_block *block)
 {
@@ -166,6 +206,41 @@ void drm_buddy_free_list(struct drm_buddy *mm,
 			 struct list_head *objects,
 			 unsigned int flags);
 
+int drm_buddy_cache_init(struct drm_buddy_cache *cache, struct drm_buddy *mm);
+
+void drm_buddy_cache_fini(struct drm_buddy_cache *cache);
+
+struct drm_buddy_block *
+drm_buddy_cache_get(struct drm_buddy_cache *cache, unsigned int order);
+
+bool drm_buddy_cache_put(struct drm_buddy_cache *cache,
+			 struct drm_buddy_block *block);
+
+int drm_buddy_cache_refill(struct drm_buddy_cache *cache, unsigned int order);
+
+void drm_buddy_cache_trim(struct drm_buddy_cache *cache, unsigned int order);
+
+bool drm_buddy_cache_drain(struct drm_buddy_cache *cache);
+
+void drm_buddy_cache_disable(struct drm_buddy_cache *cache);
+
+void drm_buddy_cache_enable(struct drm_buddy_cache *cache);
+
+void drm_buddy_cache_print(struct drm_buddy_cache *cache,
+			   struct drm_printer *p);
+
+unsigned int drm_buddy_fragmentation(struct drm_buddy *mm, unsigned int order);
+
+int drm_buddy_compact_target(struct drm_buddy *mm, unsigned int order,
+			     bool (*movable)(struct drm_buddy_block *block,
+					     void *arg),
+			     void *arg, u64 *start);
+
+void drm_buddy_for_each_allocated(struct drm_buddy *mm, u64 start, u64 end,
+				  void (*fn)(struct drm_buddy_block *block,
+					     void *arg),
+				  void *arg);
+
 void drm_buddy_print(struct drm_buddy *mm, struct drm_printer *p);
 void drm_buddy_block_print(struct drm_buddy *mm,
 			   struct drm_buddy_block *block,
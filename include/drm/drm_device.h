@@ -311,6 +311,23 @@ struct drm_device {
 	char busid_str[128];
 	int modesetting;
 	bool fictitious_range_registered;
+	/**
+	 * @exec_stats:
+	 *
+	 * Lock contention statistics of the &drm_exec contexts locking objects
+	 * of this device, exported through the hw.dri.N.exec sysctl.
+	 */
+	struct {
+		/** @exec_stats.contended: contexts which had to restart */
+		atomic64_t contended;
+		/** @exec_stats.restarts: total number of restarts */
+		atomic64_t restarts;
+		/**
+		 * @exec_stats.restart_ns: time from the first contention until
+		 * all objects were locked, in ns
+		 */
+		atomic64_t restart_ns;
+	} exec_stats;
 /* FIXME: Should be defined in linux/mmzone.h and include linux/mmzone.h in the
  * correct headers, such as gfp.h. */
 #define	MAX_ORDER 11
@@ -4,11 +4,13 @@
 #define __DRM_EXEC_H__
 
 #include <linux/compiler.h>
+#include <linux/ktime.h>
 #include <linux/ww_mutex.h>
 
 #define DRM_EXEC_INTERRUPTIBLE_WAIT	BIT(0)
 #define DRM_EXEC_IGNORE_DUPLICATES	BIT(1)
 
+struct drm_device;
 struct drm_gem_object;
 
 /**
@@ -49,6 +51,27 @@ struct drm_exec {
 	 * @prelocked: already locked GEM object due to contention
 	 */
 	struct drm_gem_object *prelocked;
+
+	/**
+	 * @objects_prealloc: @objects is caller provided storage and must not
+	 * be freed or reallocated
+	 */
+	bool			objects_prealloc;
+
+	/**
+	 * @restarts: number of times the locking loop restarted on contention
+	 */
+	unsigned int		restarts;
+
+	/**
+	 * @contended_start: time of the first contention
+	 */
+	ktime_t			contended_start;
+
+	/**
+	 * @contended_dev: device the contention statistics are accounted to
+	 */
+	struct drm_device	*contended_dev;
 };
 
 /**
@@ -136,6 +159,8 @@ static inline bool drm_exec_is_contended(struct drm_exec *exec)
 }
 
 void drm_exec_init(struct drm_exec *exec, u32 flags, unsigned nr);
+void drm_exec_init_array(struct drm_exec *exec, u32 flags,
+			 struct drm_gem_object **objects, unsigned int nr);
 void drm_exec_fini(struct drm_exec *exec);
 bool drm_exec_cleanup(struct drm_exec *exec);
 int drm_exec_lock_obj(struct drm_exec *exec, struct drm_gem_object *obj);
@@ -146,5 +171,9 @@ int drm_exec_prepare_array(struct drm_exec *exec,
 			   struct drm_gem_object **objects,
 			   unsigned int num_objects,
 			   unsigned int num_fences);
+int drm_exec_prepare_array_sorted(struct drm_exec *exec,
+				  struct drm_gem_object **objects,
+				  unsigned int num_objects,
+				  unsigned int num_fences);
 
 #endif
@@ -377,6 +377,17 @@ struct drm_file {
 	 */
 	struct list_head event_list;
 
+	/**
+	 * @event_wake_link:
+	 *
+	 * Entry in the list of files to wake up once a batch of events has
+	 * been queued, see drm_send_event_batch_wake(). Empty unless the file
+	 * is on such a list.
+	 *
+	 * Protect by &drm_device.event_lock.
+	 */
+	struct list_head event_wake_link;
+
 	/**
 	 * @event_space:
 	 *
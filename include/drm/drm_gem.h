@@ -430,6 +430,24 @@ struct drm_gem_object {
 	 * The current LRU list that the GEM object is on.
 	 */
 	struct drm_gem_lru *lru;
+
+#ifdef __FreeBSD__
+	/**
+	 * @cpu_faults:
+	 *
+	 * Number of CPU page faults serviced for this object, reported through
+	 * the hw.dri.N.bo_faults sysctl.
+	 */
+	atomic_long_t cpu_faults;
+
+	/**
+	 * @cpu_large_prefaults:
+	 *
+	 * Number of those faults which prefaulted a whole contiguous 2 MiB
+	 * range. The range is still mapped with 4K PTEs.
+	 */
+	atomic_long_t cpu_large_prefaults;
+#endif
 };
 
 /**
@@ -535,6 +553,8 @@ void drm_gem_vunmap_unlocked(struct drm_gem_object *obj, struct iosys_map *map);
 
 int drm_gem_objects_lookup(struct drm_file *filp, void __user *bo_handles,
 			   int count, struct drm_gem_object ***objs_out);
+int drm_gem_objects_lookup_array(struct drm_file *filp, const u32 *handles,
+				 int count, struct drm_gem_object **objs);
 struct drm_gem_object *drm_gem_object_lookup(struct drm_file *filp, u32 handle);
 long drm_gem_dma_resv_wait(struct drm_file *filep, u32 handle,
 				    bool wait_all, unsigned long timeout);
@@ -262,6 +262,13 @@ struct drm_gpuvm {
 		 * @rb.list: the &list_head to track GPU VA mappings
 		 */
 		struct list_head list;
+
+		/**
+		 * @rb.last: the &drm_gpuva found by the last lookup, used to
+		 * answer lookups of the same or the following mapping without
+		 * descending the tree
+		 */
+		struct drm_gpuva *last;
 	} rb;
 
 	/**
@@ -454,6 +461,24 @@ __drm_gpuva_next(struct drm_gpuva *va)
 	     va__ && (va__->va.addr < (end__)); \
 	     va__ = __drm_gpuva_next(va__))
 
+/**
+ * drm_gpuvm_for_each_va_range_continue() - continue iterating over a range of
+ * &drm_gpuvas
+ * @va__: &drm_gpuva to continue from, assigned to in each iteration step
+ * @end__: ending offset, the last gpuva will start before this (but may
+ * overlap)
+ *
+ * This iterator continues the walk after the given &drm_gpuva, e.g. one
+ * obtained from a previous lookup or iteration, up to @end__. It is implemented
+ * similarly to list_for_each_entry_continue() and never descends the interval
+ * tree, which makes it suitable for handling consecutive faults. It isn't safe
+ * against removal of elements.
+ */
+#define drm_gpuvm_for_each_va_range_continue(va__, end__) \
+	for (va__ = __drm_gpuva_next(va__); \
+	     va__ && (va__->va.addr < (end__)); \
+	     va__ = __drm_gpuva_next(va__))
+
 /**
  * drm_gpuvm_for_each_va_range_safe() - safely iterate over a range of
  * &drm_gpuvas
@@ -916,6 +941,16 @@ struct drm_gpuva_op_remap {
 	 * @unmap: the unmap operation for the original existing mapping
 	 */
 	struct drm_gpuva_op_unmap *unmap;
+
+	/**
+	 * @next_unmap:
+	 *
+	 * Only set in the ops of drm_gpuvm_sm_batch_ops_create(), when a later
+	 * request of the batch splits or unmaps @next again. drm_gpuva_remap()
+	 * points the &drm_gpuva_op_unmap.va of that later remap or unmap at
+	 * the &drm_gpuva it inserted for @next.
+	 */
+	struct drm_gpuva_op_unmap *next_unmap;
 };
 
 /**
@@ -975,6 +1010,8 @@ struct drm_gpuva_op {
 	};
 };
 
+struct drm_gpuva_op_chunk;
+
 /**
  * struct drm_gpuva_ops - wraps a list of &drm_gpuva_op
  */
@@ -983,6 +1020,12 @@ struct drm_gpuva_ops {
 	 * @list: the &list_head
 	 */
 	struct list_head list;
+
+	/**
+	 * @pool: chunks the ops were carved from, if created by
+	 * drm_gpuvm_sm_batch_ops_create(); NULL otherwise
+	 */
+	struct drm_gpuva_op_chunk *pool;
 };
 
 /**
@@ -1061,6 +1104,36 @@ struct drm_gpuva_ops *
 drm_gpuvm_sm_unmap_ops_create(struct drm_gpuvm *gpuvm,
 			      u64 addr, u64 range);
 
+/**
+ * struct drm_gpuvm_bind_req - a single map or unmap request of a batch
+ */
+struct drm_gpuvm_bind_req {
+	/**
+	 * @addr: the start address of the range
+	 */
+	u64 addr;
+
+	/**
+	 * @range: the size of the range
+	 */
+	u64 range;
+
+	/**
+	 * @obj: the &drm_gem_object to map, NULL to unmap the range
+	 */
+	struct drm_gem_object *obj;
+
+	/**
+	 * @offset: the offset within @obj
+	 */
+	u64 offset;
+};
+
+struct drm_gpuva_ops *
+drm_gpuvm_sm_batch_ops_create(struct drm_gpuvm *gpuvm,
+			      const struct drm_gpuvm_bind_req *reqs,
+			      unsigned int count);
+
 struct drm_gpuva_ops *
 drm_gpuvm_prefetch_ops_create(struct drm_gpuvm *gpuvm,
 				 u64 addr, u64 range);
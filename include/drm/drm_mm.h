@@ -72,7 +72,9 @@ enum drm_mm_insert_mode {
 	 * @DRM_MM_INSERT_BEST:
 	 *
 	 * Search for the smallest hole (within the search range) that fits
-	 * the desired node.
+	 * the desired node. If the first few candidates are ruled out by the
+	 * range, alignment or color, the lowest fitting hole in the range is
+	 * used instead.
 	 *
 	 * Allocates the node from the bottom of the found hole.
 	 */
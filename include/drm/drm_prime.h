@@ -32,10 +32,13 @@
 #ifndef __DRM_PRIME_H__
 #define __DRM_PRIME_H__
 
+#include <linux/hashtable.h>
 #include <linux/mutex.h>
 #include <linux/rbtree.h>
 #include <linux/scatterlist.h>
 
+#define DRM_PRIME_HASH_BITS 6
+
 /**
  * struct drm_prime_file_private - per-file tracking for PRIME
  *
@@ -47,6 +50,8 @@ struct drm_prime_file_private {
 	struct mutex lock;
 	struct rb_root dmabufs;
 	struct rb_root handles;
+	/* dma_buf -> handle index for lockless lookups, updated under lock */
+	DECLARE_HASHTABLE(dmabuf_hash, DRM_PRIME_HASH_BITS);
 };
 
 struct device;
@@ -36,6 +36,9 @@
 struct debugfs_regset32;
 struct drm_device;
 struct seq_file;
+#ifdef __FreeBSD__
+struct sbuf;
+#endif
 
 /* Do *not* use outside of drm_print.[ch]! */
 extern unsigned long __drm_debug;
@@ -184,6 +187,10 @@ void __drm_printfn_coredump(struct drm_printer *p, struct va_format *vaf);
 void __drm_puts_coredump(struct drm_printer *p, const char *str);
 void __drm_printfn_seq_file(struct drm_printer *p, struct va_format *vaf);
 void __drm_puts_seq_file(struct drm_printer *p, const char *str);
+#ifdef __FreeBSD__
+void __drm_printfn_sbuf(struct drm_printer *p, struct va_format *vaf);
+void __drm_puts_sbuf(struct drm_printer *p, const char *str);
+#endif
 void __drm_printfn_info(struct drm_printer *p, struct va_format *vaf);
 void __drm_printfn_dbg(struct drm_printer *p, struct va_format *vaf);
 void __drm_printfn_err(struct drm_printer *p, struct va_format *vaf);
@@ -301,6 +308,25 @@ static inline struct drm_printer drm_seq_file_printer(struct seq_file *f)
 	return p;
 }
 
+#ifdef __FreeBSD__
+/**
+ * drm_sbuf_printer - construct a &drm_printer that outputs to &sbuf
+ * @sb:  the &struct sbuf to output to
+ *
+ * RETURNS:
+ * The &drm_printer object
+ */
+static inline struct drm_printer drm_sbuf_printer(struct sbuf *sb)
+{
+	struct drm_printer p = {
+		.printfn = __drm_printfn_sbuf,
+		.puts = __drm_puts_sbuf,
+		.arg = sb,
+	};
+	return p;
+}
+#endif
+
 /**
  * drm_info_printer - construct a &drm_printer that outputs to dev_printk()
  * @dev: the &struct device pointer
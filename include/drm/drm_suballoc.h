@@ -12,6 +12,9 @@
 #include <linux/types.h>
 
 #define DRM_SUBALLOC_MAX_QUEUES 32
+
+struct drm_suballoc_ring;
+
 /**
  * struct drm_suballoc_manager - fenced range allocations
  * @wq: Wait queue for sleeping allocations on contention.
@@ -20,6 +23,7 @@
  * @flist: Array[fence context hash] of queues of fenced allocated ranges.
  * @size: Size of the managed range.
  * @align: Default alignment for the managed range.
+ * @ring: Ring mode state, see drm_suballoc_manager_init_ring().
  */
 struct drm_suballoc_manager {
 	wait_queue_head_t wq;
@@ -28,6 +32,7 @@ struct drm_suballoc_manager {
 	struct list_head flist[DRM_SUBALLOC_MAX_QUEUES];
 	size_t size;
 	size_t align;
+	struct drm_suballoc_ring *ring;
 };
 
 /**
@@ -38,6 +43,9 @@ struct drm_suballoc_manager {
  * @soffset: Start offset.
  * @eoffset: End offset + 1 so that @eoffset - @soffset = size.
  * @fence: The fence protecting the allocation.
+ * @cb: Ring mode fence callback retiring the range.
+ * @vstart: Ring mode position.
+ * @vsize: Ring mode length.
  */
 struct drm_suballoc {
 	struct list_head olist;
@@ -46,11 +54,17 @@ struct drm_suballoc {
 	size_t soffset;
 	size_t eoffset;
 	struct dma_fence *fence;
+	struct dma_fence_cb cb;
+	u64 vstart;
+	size_t vsize;
 };
 
 void drm_suballoc_manager_init(struct drm_suballoc_manager *sa_manager,
 			       size_t size, size_t align);
 
+int drm_suballoc_manager_init_ring(struct drm_suballoc_manager *sa_manager,
+				   size_t size, size_t align);
+
 void drm_suballoc_manager_fini(struct drm_suballoc_manager *sa_manager);
 
 struct drm_suballoc *
@@ -60,7 +60,26 @@ struct drm_syncobj {
 	struct list_head ev_fd_list;
 #endif
 	/**
-	 * @lock: Protects &cb_list and &ev_fd_list, and write-locks &fence.
+	 * @points:
+	 *
+	 * Timeline points of the current chain context ordered by seqno. Each
+	 * entry holds a reference to its &dma_fence_chain node, which lets
+	 * point lookups avoid walking the chain. Protected by &lock.
+	 */
+	struct rb_root points;
+	/**
+	 * @points_signaled: All points up to this one are known to be
+	 * signaled and have been dropped from &points.
+	 */
+	u64 points_signaled;
+	/**
+	 * @points_uncovered: Points up to this one belong to the chain but are
+	 * not in &points, lookups for them have to walk the chain.
+	 */
+	u64 points_uncovered;
+	/**
+	 * @lock: Protects &cb_list, &ev_fd_list and &points, and write-locks
+	 * &fence.
 	 */
 	spinlock_t lock;
 	/**
@@ -0,0 +1,96 @@
+/*-
+ * SPDX-License-Identifier: BSD-2-Clause
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _DRM_TRACE_RING_FREEBSD_H_
+#define _DRM_TRACE_RING_FREEBSD_H_
+
+#include <sys/types.h>
+#include <sys/sdt.h>
+#include <machine/atomic.h>
+
+/*
+ * Binary event trace for DRM core, the GPU scheduler and TTM.
+ *
+ * Every event fires a dtrace SDT probe drm:::<name> and, while
+ * hw.dri.trace.enabled is set, is also appended to a per-CPU ring which
+ * hw.dri.trace.ring returns as an array of struct drm_trace_record.
+ * scripts/drmtrace2json converts that into a Chrome trace / Perfetto
+ * timeline.
+ */
+
+enum drm_trace_type {
+	DRM_TRACE_VBLANK = 1,		/* crtc, seq, time_ns, high_prec */
+	DRM_TRACE_VBLANK_QUEUED,	/* file, crtc, seq */
+	DRM_TRACE_VBLANK_DELIVERED,	/* file, crtc, seq */
+	DRM_TRACE_JOB_QUEUED,		/* s_fence, job id, entity */
+	DRM_TRACE_JOB_RUN,		/* s_fence, job id, entity */
+	DRM_TRACE_JOB_DONE,		/* s_fence */
+	DRM_TRACE_FENCE_SIGNAL,		/* fence, context, seqno, error */
+	DRM_TRACE_BO_MOVE,		/* bo, size, old mem_type, new mem_type */
+	DRM_TRACE_BO_EVICT,		/* bo, size, old mem_type, new mem_type */
+};
+
+/*
+ * One ring entry. seq is the record's position in its CPU ring plus one and
+ * is written last, records overwritten while the ring was read are dropped.
+ */
+struct drm_trace_record {
+	uint64_t seq;
+	uint64_t time_ns;		/* sbinuptime() in ns */
+	uint32_t type;			/* enum drm_trace_type */
+	uint32_t cpu;
+	uint64_t args[4];
+};
+
+SDT_PROVIDER_DECLARE(drm);
+SDT_PROBE_DECLARE(drm, , , vblank);
+SDT_PROBE_DECLARE(drm, , , vblank__queued);
+SDT_PROBE_DECLARE(drm, , , vblank__delivered);
+SDT_PROBE_DECLARE(drm, , , job__queued);
+SDT_PROBE_DECLARE(drm, , , job__run);
+SDT_PROBE_DECLARE(drm, , , job__done);
+SDT_PROBE_DECLARE(drm, , , fence__signal);
+SDT_PROBE_DECLARE(drm, , , bo__move);
+SDT_PROBE_DECLARE(drm, , , bo__evict);
+
+extern bool drm_trace_ring_active;
+
+void drm_trace_ring_write(uint32_t type, uint64_t arg0, uint64_t arg1,
+    uint64_t arg2, uint64_t arg3);
+
+/*
+ * The acquire pairs with the release store of the enable sysctl, so that
+ * the rings allocated before enabling are visible to drm_trace_ring_write().
+ */
+#define	DRM_TRACE(probe, type, arg0, arg1, arg2, arg3) do {		\
+	SDT_PROBE4(drm, , , probe, arg0, arg1, arg2, arg3);		\
+	if (__predict_false(atomic_load_acq_char(			\
+	    (volatile u_char *)&drm_trace_ring_active)))		\
+		drm_trace_ring_write(type, (uint64_t)(arg0),		\
+		    (uint64_t)(arg1), (uint64_t)(arg2),			\
+		    (uint64_t)(arg3));					\
+} while (0)
+
+#endif /* _DRM_TRACE_RING_FREEBSD_H_ */
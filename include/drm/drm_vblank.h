@@ -223,6 +223,19 @@ struct drm_vblank_crtc {
 	 * cancelled.
 	 */
 	wait_queue_head_t work_wait_queue;
+
+#ifdef __FreeBSD__
+	/**
+	 * @missed: Vblanks the interrupt handler found the counter to have
+	 * skipped over. Protected by @seqlock.
+	 */
+	u64 missed;
+	/**
+	 * @queued: Vblank events still pending on this CRTC after the last
+	 * vblank was handled. Protected by @seqlock.
+	 */
+	u32 queued;
+#endif
 };
 
 struct drm_vblank_crtc *drm_crtc_vblank_crtc(struct drm_crtc *crtc);
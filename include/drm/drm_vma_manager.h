@@ -49,9 +49,18 @@ struct drm_vma_offset_file {
 	unsigned long vm_count;
 };
 
+/*
+ * Most nodes are only ever opened by one or two files, those are kept inline
+ * in the node where drm_vma_node_is_allowed() can check them without taking
+ * vm_lock. Additional files go to the vm_files tree.
+ */
+#define DRM_VMA_NODE_INLINE_FILES 2
+
 struct drm_vma_offset_node {
 	rwlock_t vm_lock;
 	struct drm_mm_node vm_node;
+	struct drm_file *vm_inline_tags[DRM_VMA_NODE_INLINE_FILES];
+	unsigned long vm_inline_count[DRM_VMA_NODE_INLINE_FILES];
 	struct rb_root vm_files;
 	void *driver_private;
 };
@@ -125,16 +125,38 @@ struct ttm_buffer_object {
 	unsigned pin_count;
 
 	/**
-	 * @delayed_delete: Work item used when we can't delete the BO
-	 * immediately
+	 * @delayed_entry: Entry in &ttm_device.delayed when we can't delete
+	 * the BO immediately, protected by &ttm_device.lru_lock
 	 */
-	struct work_struct delayed_delete;
+	struct list_head delayed_entry;
+
+	/**
+	 * @delayed_fence: Unsignaled fence of a BO on &ttm_device.delayed
+	 * which @delayed_cb is armed on, only used by the delayed delete work
+	 */
+	struct dma_fence *delayed_fence;
+
+	/**
+	 * @delayed_cb: Callback re-running the delayed delete work once
+	 * @delayed_fence signals
+	 */
+	struct dma_fence_cb delayed_cb;
 
 	/**
 	 * @sg: external source of pages and DMA addresses, protected by the
 	 * reservation lock.
 	 */
 	struct sg_table *sg;
+
+#ifdef __FreeBSD__
+	/**
+	 * @fault_next: Page offset right behind the last prefault window and
+	 * @fault_window: its size, used to adapt the window to the access
+	 * pattern. Protected by the reservation lock.
+	 */
+	pgoff_t fault_next;
+	unsigned int fault_window;
+#endif
 };
 
 #define TTM_BO_MAP_IOMEM_MASK 0x80
@@ -266,6 +266,24 @@ struct ttm_device {
 	 * @wq: Work queue structure for the delayed delete workqueue.
 	 */
 	struct workqueue_struct *wq;
+
+	/**
+	 * @delayed: Released but not yet idle BOs waiting for destruction,
+	 * protected by @lru_lock.
+	 */
+	struct list_head delayed;
+
+	/**
+	 * @delayed_work: Work item destroying the idle BOs on @delayed, run
+	 * again by a fence callback on each busy one.
+	 */
+	struct work_struct delayed_work;
+
+	/**
+	 * @delayed_flushing: Set while ttm_device_flush_delayed() runs, which
+	 * keeps @delayed_work off @delayed. Protected by @lru_lock.
+	 */
+	bool delayed_flushing;
 };
 
 int ttm_global_swapout(struct ttm_operation_ctx *ctx, gfp_t gfp_flags);
@@ -297,6 +315,7 @@ int ttm_device_init(struct ttm_device *bdev, const struct ttm_device_funcs *func
 		    struct drm_vma_offset_manager *vma_manager,
 		    bool use_dma_alloc, bool use_dma32);
 void ttm_device_fini(struct ttm_device *bdev);
+void ttm_device_flush_delayed(struct ttm_device *bdev);
 void ttm_device_clear_dma_mappings(struct ttm_device *bdev);
 
 #endif
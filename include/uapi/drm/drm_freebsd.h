@@ -0,0 +1,124 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _DRM_FREEBSD_H_
+#define _DRM_FREEBSD_H_
+
+#include "drm.h"
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/*
+ * FreeBSD private DRM core ioctls.
+ *
+ * These live in their own ioctl group, so that they can never collide with
+ * the core (0x00 - 0x3f, 0xa0 - 0xff) and driver (0x40 - 0x9f) numbers of
+ * the upstream DRM_IOCTL_BASE group.
+ */
+#define DRM_FREEBSD_IOCTL_BASE		'D'
+#define DRM_FREEBSD_IOWR(nr, type)	_IOWR(DRM_FREEBSD_IOCTL_BASE, nr, type)
+
+#define DRM_SYNCOBJ_OP_RESET		0 /* like DRM_IOCTL_SYNCOBJ_RESET */
+#define DRM_SYNCOBJ_OP_SIGNAL		1 /* like DRM_IOCTL_SYNCOBJ_SIGNAL */
+#define DRM_SYNCOBJ_OP_TIMELINE_SIGNAL	2 /* like DRM_IOCTL_SYNCOBJ_TIMELINE_SIGNAL */
+#define DRM_SYNCOBJ_OP_TRANSFER		3 /* like DRM_IOCTL_SYNCOBJ_TRANSFER */
+
+/**
+ * struct drm_syncobj_op - a single operation of &DRM_IOCTL_SYNCOBJ_BATCH
+ * @op: One of the DRM_SYNCOBJ_OP_* operations.
+ * @handle: Syncobj to operate on, the destination for transfers.
+ * @point: Timeline point to signal or transfer to, zero for binary syncobjs.
+ * @src_handle: Source syncobj of a transfer, must be zero otherwise.
+ * @flags: &DRM_SYNCOBJ_WAIT_FLAGS_WAIT_FOR_SUBMIT for transfers, must be zero
+ *         otherwise.
+ * @src_point: Source timeline point of a transfer, must be zero otherwise.
+ * @pad: Must be zero.
+ */
+struct drm_syncobj_op {
+	__u32 op;
+	__u32 handle;
+	__u64 point;
+	__u32 src_handle;
+	__u32 flags;
+	__u64 src_point;
+	__u64 pad;
+};
+
+/**
+ * struct drm_syncobj_batch - arguments of &DRM_IOCTL_SYNCOBJ_BATCH
+ * @ops: Pointer to an array of struct drm_syncobj_op.
+ * @count_ops: Number of operations in @ops.
+ * @flags: Must be zero.
+ * @pad: Must be zero.
+ *
+ * All handles are resolved and all fences are looked up before the first
+ * operation is applied, so either every operation takes effect in array
+ * order or none does. Transfer sources see the state from before the batch.
+ */
+struct drm_syncobj_batch {
+	__u64 ops;
+	__u32 count_ops;
+	__u32 flags;
+	__u64 pad;
+};
+
+/**
+ * DRM_IOCTL_SYNCOBJ_BATCH - Apply a list of syncobj operations.
+ *
+ * Combines any number of reset, signal, timeline signal and transfer
+ * operations into a single call. See struct drm_syncobj_batch.
+ */
+#define DRM_IOCTL_SYNCOBJ_BATCH		DRM_FREEBSD_IOWR(0x00, struct drm_syncobj_batch)
+
+/**
+ * struct drm_vblank_crtc_stats - contents of hw.dri.<N>.vblank_stats.<crtc>
+ * @size: Size of the structure the kernel filled in. Later versions only
+ *        append members, callers must check that it covers what they read.
+ * @enabled: Whether the vblank interrupt is enabled.
+ * @count: Vblank counter.
+ * @time_ns: CLOCK_MONOTONIC timestamp of @count.
+ * @missed: Vblanks skipped between interrupts.
+ * @queued: Events pending after the last vblank.
+ * @pad: Zero.
+ *
+ * Binary per-CRTC vblank state for monitoring tools sampling at a high
+ * rate. The snapshot is consistent against the vblank interrupt. A buffer
+ * shorter than the kernel's structure receives a truncated copy.
+ */
+struct drm_vblank_crtc_stats {
+	__u32 size;
+	__u32 enabled;
+	__u64 count;
+	__s64 time_ns;
+	__u64 missed;
+	__u32 queued;
+	__u32 pad;
+};
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* _DRM_FREEBSD_H_ */
@@ -30,6 +30,12 @@
 #include <linux/dma-fence.h>
 #include <linux/irq_work.h>
 
+/*
+ * Arrays of up to this many fences come from a dedicated UMA zone and can keep
+ * the fence pointers inline instead of in a separate allocation.
+ */
+#define	DMA_FENCE_ARRAY_INLINE	4
+
 struct dma_fence_array_cb {
 	struct dma_fence_cb cb;
 	struct dma_fence_array *array;
@@ -42,6 +48,7 @@ struct dma_fence_array {
 	atomic_t num_pending;
 	struct dma_fence **fences;
 	struct irq_work work;
+	struct dma_fence *inline_fences[DMA_FENCE_ARRAY_INLINE];
 	struct dma_fence_array_cb callbacks[] __counted_by(num_fences);
 };
 
@@ -51,6 +58,10 @@ struct dma_fence_array {
 	     (index)++, fence = dma_fence_array_next(head, index))
 
 struct dma_fence_array *to_dma_fence_array(struct dma_fence *fence);
+struct dma_fence_array *dma_fence_array_alloc(int num_fences);
+void dma_fence_array_init(struct dma_fence_array *array, int num_fences,
+    struct dma_fence **fences, u64 context, unsigned seqno,
+    bool signal_on_any);
 struct dma_fence_array *dma_fence_array_create(int num_fences,
     struct dma_fence **fences, u64 context, unsigned seqno,
     bool signal_on_any);
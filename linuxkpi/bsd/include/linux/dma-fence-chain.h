@@ -28,6 +28,7 @@
 #define _LINUX_DMA_FENCE_CHAIN_H_
 
 #include <linux/dma-fence.h>
+#include <linux/rbtree.h>
 #include <linux/irq_work.h>
 
 struct dma_fence_chain {
@@ -40,6 +41,8 @@ struct dma_fence_chain {
 		struct irq_work work;
 	};
 	spinlock_t lock;
+	/* Entry in the timeline point index of the owning drm_syncobj. */
+	struct rb_node point_node;
 };
 
 #define dma_fence_chain_for_each(iter, head)	\
@@ -59,15 +62,12 @@ dma_fence_chain_contained(struct dma_fence *fence)
 	return (chain != NULL ? chain->fence : fence);
 }
 
-MALLOC_DECLARE(M_DMABUF);
-
-#define dma_fence_chain_alloc() \
-    ((struct dma_fence_chain *)kmalloc(sizeof(struct dma_fence_chain), GFP_KERNEL))
-
-static inline void
-dma_fence_chain_free(struct dma_fence_chain *chain)
-{
-	kfree(chain);
-}
+/*
+ * Chain nodes come from a dedicated UMA zone. dma_fence_chain_free() is only
+ * for nodes which were never initialized, the rest are released through
+ * their reference count.
+ */
+struct dma_fence_chain *dma_fence_chain_alloc(void);
+void dma_fence_chain_free(struct dma_fence_chain *chain);
 
 #endif /* _LINUX_DMA_FENCE_CHAIN_H_ */
@@ -176,6 +176,23 @@ struct dma_resv {
 	 * reserved by calling dma_resv_reserve_fences().
 	 */
 	struct dma_resv_list __rcu *fences;
+
+	/**
+	 * @prune_link:
+	 *
+	 * Entry in the queue of objects whose fence list is periodically
+	 * compacted by the background pruning worker. Private to dma-resv.c.
+	 */
+	struct list_head prune_link;
+
+	/** @prune_queued: true once the object was queued for pruning */
+	bool prune_queued;
+
+	/**
+	 * @prune_busy: set while the pruning worker compacts the object,
+	 * dma_resv_fini() waits for it to clear. Protected by the prune lock.
+	 */
+	bool prune_busy;
 };
 
 /**
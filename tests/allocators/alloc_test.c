@@ -0,0 +1,1102 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Randomized alloc/free sequences for drm_mm, drm_buddy and drm_suballoc,
+ * each operation checked against a brute force model of the managed range:
+ * a map of which units are in use, searched exhaustively for where a request
+ * could have been placed. Besides catching overlapping or misplaced ranges,
+ * this checks that the allocators fail only when the model finds no room,
+ * which is how stale search trees and overly eager pruning show up.
+ *
+ * Only the allocator calls are timed, for ops/sec and worst-case latency.
+ * Failures print the seed, rerun with -s to reproduce.
+ */
+
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+
+#include <drm/drm_buddy.h>
+#include <drm/drm_mm.h>
+#include <drm/drm_suballoc.h>
+
+#include <err.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "shim.h"
+
+static uint64_t seed;
+static uint64_t rng;
+static uint64_t op;
+
+static uint64_t
+rnd(void)
+{
+	/* xorshift64* */
+	rng ^= rng >> 12;
+	rng ^= rng << 25;
+	rng ^= rng >> 27;
+	return (rng * 0x2545F4914F6CDD1DULL);
+}
+
+static uint64_t
+rnd_below(uint64_t n)
+{
+	return (n ? rnd() % n : 0);
+}
+
+/*
+ * Request sizes, picked with -w. Sizes are in the allocation unit of the
+ * test: drm_mm units, 4K buddy chunks or suballocator bytes.
+ */
+
+/* Log-uniform in [1, max], most requests are small. */
+static uint64_t
+size_loguniform(uint64_t max)
+{
+	uint64_t n = 1ULL << rnd_below(ilog2(max) + 1);
+
+	return (1 + rnd_below(min(n, max)));
+}
+
+static uint64_t
+size_uniform(uint64_t max)
+{
+	return (1 + rnd_below(max));
+}
+
+/* P(size >= s) ~ 1/s: mostly tiny requests, with a long tail up to max. */
+static uint64_t
+size_powerlaw(uint64_t max)
+{
+	return (max / (1 + rnd_below(max)));
+}
+
+/*
+ * Tiny requests with the odd one from the top quarter. The tiny ones that
+ * stay behind pin the holes the large ones leave, so free space ends up
+ * split into pieces too small for the next large request.
+ */
+static uint64_t
+size_frag(uint64_t max)
+{
+	if (rnd_below(8) == 0)
+		return (max - rnd_below(max / 4 + 1));
+	return (1 + rnd_below(max / 64 + 1));
+}
+
+static uint64_t *trace;
+static size_t trace_len, trace_pos;
+
+/* Sizes from the trace file in turn, wrapping around, clamped to max. */
+static uint64_t
+size_trace(uint64_t max)
+{
+	uint64_t size = trace[trace_pos++ % trace_len];
+
+	return (clamp(size, 1, max));
+}
+
+static uint64_t (*rnd_size)(uint64_t max) = size_loguniform;
+
+static const struct {
+	const char *name;
+	uint64_t (*fn)(uint64_t max);
+} workloads[] = {
+	{ "loguniform", size_loguniform },
+	{ "uniform", size_uniform },
+	{ "powerlaw", size_powerlaw },
+	{ "frag", size_frag },
+};
+
+/*
+ * One size per line, decimal or 0x-prefixed hex, with # comments. Only the
+ * sizes are replayed, which requests are freed and when stays random.
+ */
+static void
+trace_load(const char *path)
+{
+	char line[128], *p, *end;
+	size_t cap = 0;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (f == NULL)
+		err(2, "%s", path);
+	while (fgets(line, sizeof(line), f) != NULL) {
+		p = line + strspn(line, " \t");
+		if (*p == '#' || *p == '\n' || *p == '\0')
+			continue;
+		if (trace_len == cap) {
+			cap = cap ? cap * 2 : 1024;
+			trace = realloc(trace, cap * sizeof(*trace));
+			if (trace == NULL)
+				err(2, "%s", path);
+		}
+		trace[trace_len] = strtoull(p, &end, 0);
+		if (end == p)
+			errx(2, "%s: bad size: %s", path, p);
+		trace_len++;
+	}
+	if (ferror(f))
+		err(2, "%s", path);
+	fclose(f);
+	if (trace_len == 0)
+		errx(2, "%s: no sizes", path);
+	rnd_size = size_trace;
+}
+
+static void
+workload_set(const char *name)
+{
+	size_t i;
+
+	if (strncmp(name, "trace:", 6) == 0) {
+		trace_load(name + 6);
+		return;
+	}
+	for (i = 0; i < ARRAY_SIZE(workloads); i++) {
+		if (strcmp(name, workloads[i].name) == 0) {
+			rnd_size = workloads[i].fn;
+			return;
+		}
+	}
+	errx(2, "unknown workload %s", name);
+}
+
+static void
+failed(const char *func, int line, const char *cond)
+{
+	fprintf(stderr, "%s:%d: %s failed (seed %" PRIu64 ", op %" PRIu64
+	    ")\n", func, line, cond, seed, op);
+	abort();
+}
+
+#define	CHECK(cond) do {						\
+	if (!(cond))							\
+		failed(__func__, __LINE__, #cond);			\
+} while (0)
+
+struct op_stat {
+	const char *name;
+	uint64_t ops;
+	uint64_t fails;
+	uint64_t ns;
+	uint64_t worst;
+};
+
+static uint64_t
+now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static void
+stat_add(struct op_stat *st, uint64_t start, bool fail)
+{
+	uint64_t ns = now_ns() - start;
+
+	st->ops++;
+	st->fails += fail;
+	st->ns += ns;
+	if (ns > st->worst)
+		st->worst = ns;
+}
+
+static void
+stat_print(const char *test, const struct op_stat *st, int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++, st++) {
+		if (!st->ops)
+			continue;
+		printf("%-8s %-10s %9" PRIu64 " ops %8" PRIu64 " failed "
+		    "%10.0f ops/s  worst %8.1f us\n", test, st->name, st->ops,
+		    st->fails, st->ns ? st->ops * 1e9 / st->ns : 0.0,
+		    st->worst / 1e3);
+	}
+}
+
+/*
+ * drm_mm
+ */
+
+#define	MM_START	12345
+#define	MM_SIZE		4096
+#define	MM_END		(MM_START + MM_SIZE)
+#define	MM_NODES	128
+
+/* Non-zero for units covered by a node. */
+static uint8_t mm_map[MM_SIZE];
+static u64 mm_used;
+
+enum { MM_INSERT, MM_RESERVE, MM_REMOVE, MM_NSTATS };
+
+static bool
+mm_map_free(u64 start, u64 size)
+{
+	u64 i;
+
+	for (i = start; i < start + size; i++)
+		if (i < MM_START || i >= MM_END || mm_map[i - MM_START])
+			return (false);
+	return (true);
+}
+
+static void
+mm_map_set(u64 start, u64 size, uint8_t v)
+{
+	u64 i;
+
+	for (i = start - MM_START; i < start - MM_START + size; i++) {
+		CHECK(mm_map[i] != v);
+		mm_map[i] = v;
+	}
+	if (v)
+		mm_used += size;
+	else
+		mm_used -= size;
+}
+
+/* Length of the free run around @addr. */
+static u64
+mm_map_run(u64 addr)
+{
+	u64 a = addr - MM_START, b = a;
+
+	while (a > 0 && !mm_map[a - 1])
+		a--;
+	while (b < MM_SIZE && !mm_map[b])
+		b++;
+	return (b - a);
+}
+
+/*
+ * Lowest and highest place in [start, end) where @size units at @align fit,
+ * and the size of the smallest free run that can take @size.
+ */
+static bool
+mm_ref_fit(u64 size, u64 align, u64 start, u64 end, u64 *low, u64 *high,
+    u64 *best)
+{
+	u64 a, b, lo, hi;
+	bool found = false;
+
+	start = max(start, (u64)MM_START);
+	end = min(end, (u64)MM_END);
+	*best = U64_MAX;
+	for (a = start; a < end; a = b + 1) {
+		for (b = a; b < end && !mm_map[b - MM_START]; b++)
+			;
+		if (b - a < size)
+			continue;
+		lo = align ? DIV_ROUND_UP(a, align) * align : a;
+		hi = b - size;
+		if (align)
+			hi -= hi % align;
+		if (lo > hi)
+			continue;
+		if (!found)
+			*low = lo;
+		*high = hi;
+		found = true;
+		*best = min(*best, mm_map_run(a));
+	}
+	return (found);
+}
+
+static void
+mm_verify(struct drm_mm *mm)
+{
+	struct drm_mm_node *node, *first;
+	u64 hole_start, hole_end, prev, used, hole, s, e;
+
+	/* Nodes in address order, each covering mapped units only. */
+	prev = MM_START;
+	used = 0;
+	drm_mm_for_each_node(node, mm) {
+		CHECK(node->start >= prev);
+		CHECK(node->size > 0 && node->start + node->size <= MM_END);
+		for (s = node->start; s < node->start + node->size; s++)
+			CHECK(mm_map[s - MM_START]);
+		prev = node->start + node->size;
+		used += node->size;
+	}
+	CHECK(used == mm_used);
+
+	/* Holes are exactly the maximal free runs of the map. */
+	hole = 0;
+	drm_mm_for_each_hole(node, mm, hole_start, hole_end) {
+		CHECK(hole_start < hole_end);
+		CHECK(mm_map_free(hole_start, hole_end - hole_start));
+		CHECK(hole_start == MM_START ||
+		    mm_map[hole_start - MM_START - 1]);
+		CHECK(hole_end == MM_END || mm_map[hole_end - MM_START]);
+		hole += hole_end - hole_start;
+	}
+	CHECK(hole == MM_SIZE - mm_used);
+
+	/* Interval tree lookup against a walk of the node list. */
+	s = MM_START + rnd_below(MM_SIZE);
+	e = s + 1 + rnd_below(MM_SIZE / 16);
+	e = min(e, (u64)MM_END);
+	first = NULL;
+	drm_mm_for_each_node(node, mm) {
+		if (node->start + node->size > s) {
+			first = node;
+			break;
+		}
+	}
+	drm_mm_for_each_node_in_range(node, mm, s, e) {
+		CHECK(node == first);
+		CHECK(node->start + node->size > s);
+		first = list_next_entry(first, node_list);
+		if (&first->node_list == drm_mm_nodes(mm))
+			first = NULL;
+	}
+	CHECK(first == NULL || first->start >= e);
+}
+
+static void
+mm_insert(struct drm_mm *mm, struct drm_mm_node *node, struct op_stat *st)
+{
+	static const enum drm_mm_insert_mode modes[] = {
+		DRM_MM_INSERT_BEST, DRM_MM_INSERT_LOW, DRM_MM_INSERT_HIGH,
+		DRM_MM_INSERT_EVICT, DRM_MM_INSERT_LOWEST,
+		DRM_MM_INSERT_HIGHEST,
+	};
+	enum drm_mm_insert_mode mode;
+	u64 size, align, start, end, low = 0, high = 0, best;
+	uint64_t t;
+	bool fit;
+	int ret;
+
+	size = rnd_size(MM_SIZE / 8);
+	switch (rnd_below(4)) {
+	case 0:
+		align = 1ULL << rnd_below(8);
+		break;
+	case 1:
+		align = 1 + rnd_below(100);
+		break;
+	default:
+		align = 0;
+		break;
+	}
+	if (rnd_below(4) == 0) {
+		start = MM_START - 16 + rnd_below(MM_SIZE + 32);
+		end = start + rnd_below(MM_END + 16 - start);
+	} else {
+		start = 0;
+		end = U64_MAX;
+	}
+	mode = modes[rnd_below(ARRAY_SIZE(modes))];
+
+	fit = mm_ref_fit(size, align, start, end, &low, &high, &best);
+
+	t = now_ns();
+	ret = drm_mm_insert_node_in_range(mm, node, size, align, 0, start,
+	    end, mode);
+	stat_add(st, t, ret != 0);
+
+	if (ret) {
+		CHECK(ret == -ENOSPC);
+		CHECK(!drm_mm_node_allocated(node));
+		/* Only the ONCE modes may give up while there is room. */
+		if (!(mode & DRM_MM_INSERT_ONCE))
+			CHECK(!fit);
+		return;
+	}
+
+	CHECK(fit);
+	CHECK(drm_mm_node_allocated(node));
+	CHECK(node->size == size);
+	CHECK(node->start >= start && node->start + size <= end);
+	CHECK(!align || node->start % align == 0);
+	CHECK(mm_map_free(node->start, size));
+	if (mode == DRM_MM_INSERT_LOW)
+		CHECK(node->start == low);
+	if (mode == DRM_MM_INSERT_HIGH)
+		CHECK(node->start == high);
+	/* Unconstrained, BEST takes the smallest hole on its first try. */
+	if (mode == DRM_MM_INSERT_BEST && !align && !start)
+		CHECK(mm_map_run(node->start) == best);
+	mm_map_set(node->start, size, 1);
+}
+
+static void
+mm_reserve(struct drm_mm *mm, struct drm_mm_node *node, struct op_stat *st)
+{
+	uint64_t t;
+	bool free;
+	int ret;
+
+	node->start = MM_START - 16 + rnd_below(MM_SIZE + 32);
+	node->size = rnd_size(MM_SIZE / 8);
+	free = mm_map_free(node->start, node->size);
+
+	t = now_ns();
+	ret = drm_mm_reserve_node(mm, node);
+	stat_add(st, t, ret != 0);
+
+	CHECK(ret == 0 || ret == -ENOSPC);
+	CHECK((ret == 0) == free);
+	if (ret)
+		memset(node, 0, sizeof(*node));
+	else
+		mm_map_set(node->start, node->size, 1);
+}
+
+static void
+test_mm(uint64_t nops)
+{
+	struct op_stat st[MM_NSTATS] = {
+		[MM_INSERT] = { .name = "insert" },
+		[MM_RESERVE] = { .name = "reserve" },
+		[MM_REMOVE] = { .name = "remove" },
+	};
+	struct drm_mm_node *nodes, *node;
+	struct drm_mm mm;
+	u64 hole_start, hole_end, largest;
+	uint64_t t;
+	int i;
+
+	memset(mm_map, 0, sizeof(mm_map));
+	mm_used = 0;
+	nodes = calloc(MM_NODES, sizeof(*nodes));
+	CHECK(nodes != NULL);
+	drm_mm_init(&mm, MM_START, MM_SIZE);
+
+	for (op = 0; op < nops; op++) {
+		node = &nodes[rnd_below(MM_NODES)];
+		if (drm_mm_node_allocated(node)) {
+			mm_map_set(node->start, node->size, 0);
+			t = now_ns();
+			drm_mm_remove_node(node);
+			stat_add(&st[MM_REMOVE], t, false);
+			CHECK(!drm_mm_node_allocated(node));
+			memset(node, 0, sizeof(*node));
+		} else if (rnd_below(8) == 0) {
+			mm_reserve(&mm, node, &st[MM_RESERVE]);
+		} else {
+			mm_insert(&mm, node, &st[MM_INSERT]);
+		}
+		if (op % 16 == 0)
+			mm_verify(&mm);
+	}
+	mm_verify(&mm);
+
+	largest = 0;
+	drm_mm_for_each_hole(node, &mm, hole_start, hole_end)
+		largest = max(largest, hole_end - hole_start);
+
+	for (i = 0; i < MM_NODES; i++)
+		if (drm_mm_node_allocated(&nodes[i]))
+			drm_mm_remove_node(&nodes[i]);
+	CHECK(drm_mm_clean(&mm));
+	drm_mm_takedown(&mm);
+	free(nodes);
+
+	stat_print("mm", st, MM_NSTATS);
+	printf("%-8s fragmentation at exit: largest hole %" PRIu64 " of %"
+	    PRIu64 " free\n", "mm", (uint64_t)largest,
+	    (uint64_t)(MM_SIZE - mm_used));
+}
+
+/*
+ * drm_buddy
+ */
+
+#define	BUDDY_CHUNK	SZ_4K
+#define	BUDDY_CHUNKS	4096
+#define	BUDDY_ALLOCS	64
+
+enum { CHUNK_FREE, CHUNK_USED, CHUNK_CACHED };
+
+/* State of each chunk, cached ones sit in the buddy cache. */
+static uint8_t buddy_map[BUDDY_CHUNKS];
+static u64 buddy_chunks;
+
+struct buddy_alloc {
+	struct list_head blocks;
+	struct drm_buddy_block *block;	/* from the cache */
+	bool used;
+};
+
+enum { BUDDY_ALLOC, BUDDY_FREE, BUDDY_GET, BUDDY_PUT, BUDDY_NSTATS };
+
+static void
+buddy_map_set(struct drm_buddy *mm, struct drm_buddy_block *block,
+    uint8_t from, uint8_t to)
+{
+	u64 i, start = drm_buddy_block_offset(block) / BUDDY_CHUNK;
+	u64 n = drm_buddy_block_size(mm, block) / BUDDY_CHUNK;
+
+	CHECK(start + n <= buddy_chunks);
+	for (i = start; i < start + n; i++) {
+		CHECK(buddy_map[i] == from);
+		buddy_map[i] = to;
+	}
+}
+
+/* Naturally aligned free windows of @win chunks inside [start, end). */
+static u64
+buddy_ref_windows(u64 start, u64 end, u64 win)
+{
+	u64 i, x, n = 0;
+
+	for (x = round_up(start, win); x + win <= end; x += win) {
+		for (i = x; i < x + win && buddy_map[i] == CHUNK_FREE; i++)
+			;
+		n += i == x + win;
+	}
+	return (n);
+}
+
+static void
+buddy_verify_avail(struct drm_buddy *mm)
+{
+	u64 i, free = 0;
+
+	for (i = 0; i < buddy_chunks; i++)
+		free += buddy_map[i] == CHUNK_FREE;
+	CHECK(mm->avail == free * BUDDY_CHUNK);
+	CHECK(mm->clear_avail <= mm->avail);
+	CHECK(drm_buddy_fragmentation(mm, rnd_below(mm->max_order + 1)) <=
+	    1000);
+}
+
+/* The model's cached chunks are whatever the magazines hold. */
+static void
+buddy_sync_cache(struct drm_buddy *mm, struct drm_buddy_cache *cache)
+{
+	struct drm_buddy_magazine *mag;
+	unsigned int i, order, j;
+	u64 k;
+
+	for (k = 0; k < buddy_chunks; k++)
+		if (buddy_map[k] == CHUNK_CACHED)
+			buddy_map[k] = CHUNK_FREE;
+	for (i = 0; i < cache->nr_mags; i++) {
+		mag = &cache->mags[i];
+		for (order = 0; order < DRM_BUDDY_CACHE_ORDERS; order++) {
+			for (j = 0; j < mag->count[order]; j++) {
+				CHECK(drm_buddy_block_order(
+				    mag->blocks[order][j]) == order);
+				CHECK(drm_buddy_block_is_allocated(
+				    mag->blocks[order][j]));
+				buddy_map_set(mm, mag->blocks[order][j],
+				    CHUNK_FREE, CHUNK_CACHED);
+			}
+		}
+	}
+}
+
+struct buddy_cover {
+	struct drm_buddy *mm;
+	u64 start, end;
+	uint8_t seen[BUDDY_CHUNKS];
+};
+
+static void
+buddy_cover_block(struct drm_buddy_block *block, void *arg)
+{
+	struct buddy_cover *c = arg;
+	u64 s = drm_buddy_block_offset(block) / BUDDY_CHUNK;
+	u64 e = s + drm_buddy_block_size(c->mm, block) / BUDDY_CHUNK;
+
+	CHECK(drm_buddy_block_is_allocated(block));
+	CHECK(s < c->end && e > c->start);
+	for (s = max(s, c->start); s < min(e, c->end); s++) {
+		CHECK(!c->seen[s - c->start]);
+		c->seen[s - c->start] = 1;
+	}
+}
+
+/* drm_buddy_for_each_allocated() visits exactly the chunks in use. */
+static void
+buddy_verify_allocated(struct drm_buddy *mm)
+{
+	static struct buddy_cover c;
+	u64 i;
+
+	c.mm = mm;
+	c.start = rnd_below(buddy_chunks);
+	c.end = c.start + 1 + rnd_below(buddy_chunks - c.start);
+	memset(c.seen, 0, c.end - c.start);
+	drm_buddy_for_each_allocated(mm, c.start * BUDDY_CHUNK,
+	    c.end * BUDDY_CHUNK, buddy_cover_block, &c);
+	for (i = c.start; i < c.end; i++)
+		CHECK(c.seen[i - c.start] == (buddy_map[i] != CHUNK_FREE));
+}
+
+static void
+buddy_alloc(struct drm_buddy *mm, struct buddy_alloc *a, struct op_stat *st)
+{
+	struct drm_buddy_block *block;
+	u64 size, min_size, start, end, total, lo, hi, off, bsize, win;
+	u64 clear_avail;
+	unsigned long flags = 0;
+	bool exact, aligned;
+	uint64_t t;
+	int ret;
+
+	min_size = BUDDY_CHUNK << rnd_below(5);
+	size = BUDDY_CHUNK * rnd_size(buddy_chunks / 4);
+	if (rnd_below(2))
+		size = round_up(size, min_size);
+	if (rnd_below(2))
+		flags |= DRM_BUDDY_TOPDOWN_ALLOCATION;
+	if (rnd_below(4) == 0)
+		flags |= DRM_BUDDY_CLEAR_ALLOCATION;
+	if (rnd_below(8) == 0)
+		flags |= DRM_BUDDY_CONTIGUOUS_ALLOCATION;
+
+	start = 0;
+	end = mm->size;
+	if (rnd_below(4) == 0) {
+		flags |= DRM_BUDDY_RANGE_ALLOCATION;
+		start = BUDDY_CHUNK * rnd_below(buddy_chunks);
+		end = start + BUDDY_CHUNK *
+		    (1 + rnd_below(buddy_chunks - start / BUDDY_CHUNK));
+		/* Now and then, exactly the range. */
+		if (rnd_below(4) == 0 && IS_ALIGNED(start, min_size) &&
+		    start + size <= mm->size)
+			end = start + size;
+	}
+	exact = start + size == end;
+	aligned = IS_ALIGNED(size, min_size);
+	if (exact && !IS_ALIGNED(start | end, min_size))
+		return;
+	if (!exact && start + size > mm->size)
+		return;
+
+	clear_avail = mm->clear_avail;
+	INIT_LIST_HEAD(&a->blocks);
+	t = now_ns();
+	ret = drm_buddy_alloc_blocks(mm, start, end, size, min_size,
+	    &a->blocks, flags);
+	stat_add(st, t, ret != 0);
+
+	if (ret) {
+		CHECK(ret == -ENOSPC);
+		CHECK(list_empty(&a->blocks));
+		start /= BUDDY_CHUNK;
+		end /= BUDDY_CHUNK;
+		if (exact) {
+			CHECK(buddy_ref_windows(start, end, 1) < end - start);
+		} else if (flags & DRM_BUDDY_CONTIGUOUS_ALLOCATION) {
+			/* It may do better, but never worse than this. */
+			if (!(flags & DRM_BUDDY_RANGE_ALLOCATION)) {
+				win = roundup_pow_of_two(size / BUDDY_CHUNK);
+				CHECK(buddy_ref_windows(0, buddy_chunks,
+				    win) == 0);
+			}
+		} else if (aligned &&
+		    (!(flags & DRM_BUDDY_RANGE_ALLOCATION) || !clear_avail)) {
+			/*
+			 * Free halves of a window whose clear state differs
+			 * are only merged one pair per attempt, and that pair
+			 * may straddle the range.
+			 */
+			win = min_size / BUDDY_CHUNK;
+			CHECK(buddy_ref_windows(start, end, win) * win <
+			    size / BUDDY_CHUNK);
+		}
+		return;
+	}
+
+	total = 0;
+	lo = U64_MAX;
+	hi = 0;
+	list_for_each_entry(block, &a->blocks, link) {
+		off = drm_buddy_block_offset(block);
+		bsize = drm_buddy_block_size(mm, block);
+		CHECK(drm_buddy_block_is_allocated(block));
+		CHECK(off % bsize == 0);
+		CHECK(off >= start && off + bsize <= end);
+		if (aligned && !exact &&
+		    !(flags & DRM_BUDDY_CONTIGUOUS_ALLOCATION))
+			CHECK(bsize >= min_size);
+		buddy_map_set(mm, block, CHUNK_FREE, CHUNK_USED);
+		total += bsize;
+		lo = min(lo, off);
+		hi = max(hi, off + bsize);
+	}
+	if (flags & DRM_BUDDY_CONTIGUOUS_ALLOCATION) {
+		/* The fallback rounds its left part up to min_size. */
+		CHECK(total >= size && total - size < min_size);
+		CHECK(hi - lo == total);
+	} else {
+		CHECK(total == size);
+		CHECK(!exact || hi - lo == size);
+	}
+	a->used = true;
+}
+
+static void
+buddy_free(struct drm_buddy *mm, struct drm_buddy_cache *cache,
+    struct buddy_alloc *a, struct op_stat *st)
+{
+	struct drm_buddy_block *block;
+	uint64_t t;
+	bool cached;
+
+	if (a->block != NULL) {
+		buddy_map_set(mm, a->block, CHUNK_USED, CHUNK_FREE);
+		t = now_ns();
+		cached = drm_buddy_cache_put(cache, a->block);
+		stat_add(&st[BUDDY_PUT], t, !cached);
+		if (!cached)
+			drm_buddy_free_block(mm, a->block);
+		a->block = NULL;
+	} else {
+		list_for_each_entry(block, &a->blocks, link)
+			buddy_map_set(mm, block, CHUNK_USED, CHUNK_FREE);
+		t = now_ns();
+		drm_buddy_free_list(mm, &a->blocks,
+		    rnd_below(2) ? DRM_BUDDY_CLEARED : 0);
+		stat_add(&st[BUDDY_FREE], t, false);
+		CHECK(list_empty(&a->blocks));
+	}
+	buddy_sync_cache(mm, cache);
+	a->used = false;
+}
+
+static void
+buddy_get(struct drm_buddy *mm, struct drm_buddy_cache *cache,
+    struct buddy_alloc *a, struct op_stat *st)
+{
+	unsigned int order = rnd_below(DRM_BUDDY_CACHE_ORDERS);
+	struct drm_buddy_block *block;
+	uint64_t t;
+
+	t = now_ns();
+	block = drm_buddy_cache_get(cache, order);
+	if (block == NULL && !drm_buddy_cache_refill(cache, order))
+		block = drm_buddy_cache_get(cache, order);
+	stat_add(st, t, block == NULL);
+
+	if (block != NULL) {
+		CHECK(drm_buddy_block_order(block) == order);
+		CHECK(drm_buddy_block_is_allocated(block));
+		buddy_sync_cache(mm, cache);
+		buddy_map_set(mm, block, CHUNK_FREE, CHUNK_USED);
+		a->block = block;
+		a->used = true;
+	} else {
+		/* Refill failing means no block of that order was free. */
+		CHECK(buddy_ref_windows(0, buddy_chunks, 1U << order) == 0);
+		buddy_sync_cache(mm, cache);
+	}
+}
+
+static void
+test_buddy(uint64_t nops)
+{
+	struct op_stat st[BUDDY_NSTATS] = {
+		[BUDDY_ALLOC] = { .name = "alloc" },
+		[BUDDY_FREE] = { .name = "free" },
+		[BUDDY_GET] = { .name = "cache_get" },
+		[BUDDY_PUT] = { .name = "cache_put" },
+	};
+	struct buddy_alloc *allocs, *a;
+	struct drm_buddy_cache cache;
+	unsigned int frag, frag_worst = 0;
+	struct drm_buddy mm;
+	uint64_t frag_sum = 0;
+	int i;
+
+	/* Not a power of two, so that there are several roots. */
+	buddy_chunks = 64 + rnd_below(BUDDY_CHUNKS - 64 + 1);
+	memset(buddy_map, 0, sizeof(buddy_map));
+	allocs = calloc(BUDDY_ALLOCS, sizeof(*allocs));
+	CHECK(allocs != NULL);
+	CHECK(drm_buddy_init(&mm, buddy_chunks * BUDDY_CHUNK,
+	    BUDDY_CHUNK) == 0);
+	CHECK(drm_buddy_cache_init(&cache, &mm) == 0);
+
+	for (op = 0; op < nops; op++) {
+		a = &allocs[rnd_below(BUDDY_ALLOCS)];
+		if (a->used)
+			buddy_free(&mm, &cache, a, st);
+		else if (rnd_below(4) == 0)
+			buddy_get(&mm, &cache, a, &st[BUDDY_GET]);
+		else
+			buddy_alloc(&mm, a, &st[BUDDY_ALLOC]);
+
+		switch (rnd_below(64)) {
+		case 0:
+			drm_buddy_cache_trim(&cache,
+			    rnd_below(DRM_BUDDY_CACHE_ORDERS));
+			buddy_sync_cache(&mm, &cache);
+			break;
+		case 1:
+			drm_buddy_cache_drain(&cache);
+			buddy_sync_cache(&mm, &cache);
+			break;
+		}
+
+		buddy_verify_avail(&mm);
+		if (op % 16 == 0)
+			buddy_verify_allocated(&mm);
+
+		frag = drm_buddy_fragmentation(&mm, 4);
+		frag_sum += frag;
+		frag_worst = max(frag_worst, frag);
+	}
+
+	for (i = 0; i < BUDDY_ALLOCS; i++)
+		if (allocs[i].used)
+			buddy_free(&mm, &cache, &allocs[i], st);
+	drm_buddy_cache_drain(&cache);
+	drm_buddy_cache_fini(&cache);
+	CHECK(mm.avail == mm.size);
+	drm_buddy_fini(&mm);
+	free(allocs);
+
+	stat_print("buddy", st, BUDDY_NSTATS);
+	printf("%-8s fragmentation for 64KiB: mean %.1f%%, worst %.1f%%\n",
+	    "buddy", nops ? frag_sum / 10.0 / nops : 0.0, frag_worst / 10.0);
+}
+
+/*
+ * drm_suballoc
+ */
+
+#define	SA_SIZE		(1 << 16)
+#define	SA_RECORDS	256
+#define	SA_LIVE		64
+
+/*
+ * Live records are allocations the test holds, busy ones have been freed
+ * with a fence that had not signaled yet, which keeps the range in use.
+ */
+struct sa_record {
+	struct drm_suballoc *sa;
+	size_t soffset, eoffset;
+	struct dma_fence *fence;
+	uint64_t seq;
+	bool live;
+};
+
+static struct sa_record sa_records[SA_RECORDS];
+static uint64_t sa_seq;
+
+enum { SA_NEW, SA_FREE, SA_NSTATS };
+
+static bool
+sa_record_busy(struct sa_record *r)
+{
+	if (r->fence != NULL && r->fence->signaled) {
+		dma_fence_put(r->fence);
+		r->fence = NULL;
+	}
+	return (r->live || r->fence != NULL);
+}
+
+static void
+sa_free(struct sa_record *r)
+{
+	struct dma_fence *fence = NULL;
+
+	/* Scatter the fences over more contexts than there are queues. */
+	if (rnd_below(4))
+		fence = shim_fence_create(rnd_below(2 *
+		    DRM_SUBALLOC_MAX_QUEUES));
+	drm_suballoc_free(r->sa, fence);
+	r->sa = NULL;
+	r->fence = fence;
+	r->live = false;
+}
+
+/* A waiting allocation gets the oldest allocation the test holds freed. */
+static bool
+sa_wait_hook(void)
+{
+	struct sa_record *r, *oldest = NULL;
+
+	for (r = sa_records; r < sa_records + SA_RECORDS; r++)
+		if (r->live && (oldest == NULL || r->seq < oldest->seq))
+			oldest = r;
+	if (oldest == NULL)
+		return (false);
+	sa_free(oldest);
+	return (true);
+}
+
+static void
+sa_new(struct drm_suballoc_manager *mgr, struct sa_record *r,
+    u64 *ring_head, struct op_stat *st)
+{
+	struct drm_suballoc *sa;
+	struct sa_record *o;
+	size_t size, align, len;
+	u64 off, expect = 0;
+	uint64_t t;
+
+	size = rnd_size(rnd_below(64) ? SA_SIZE / 4 : SA_SIZE);
+	align = rnd_below(2) ? 0 : 1UL << rnd_below(ilog2(mgr->align) + 1);
+
+	if (mgr->ring != NULL) {
+		/* Bumped off the head, skipping to the next lap if needed. */
+		len = round_up(size, mgr->align);
+		off = *ring_head % SA_SIZE;
+		if (off + len > SA_SIZE)
+			*ring_head += SA_SIZE - off;
+		expect = *ring_head;
+		*ring_head += len;
+	}
+
+	t = now_ns();
+	sa = drm_suballoc_new(mgr, size, GFP_KERNEL, true, align);
+	stat_add(st, t, IS_ERR(sa));
+
+	CHECK(!IS_ERR(sa));
+	CHECK(drm_suballoc_size(sa) == size);
+	CHECK(drm_suballoc_eoffset(sa) <= SA_SIZE);
+	CHECK(drm_suballoc_soffset(sa) % (align ? align : mgr->align) == 0);
+	if (mgr->ring != NULL)
+		CHECK(sa->vstart == expect);
+	for (o = sa_records; o < sa_records + SA_RECORDS; o++)
+		if (sa_record_busy(o))
+			CHECK(sa->eoffset <= o->soffset ||
+			    sa->soffset >= o->eoffset);
+
+	r->sa = sa;
+	r->soffset = sa->soffset;
+	r->eoffset = sa->eoffset;
+	r->seq = sa_seq++;
+	r->live = true;
+}
+
+static void
+test_sa(uint64_t nops, bool ring)
+{
+	struct op_stat st[SA_NSTATS] = {
+		[SA_NEW] = { .name = "new" },
+		[SA_FREE] = { .name = "free" },
+	};
+	struct drm_suballoc_manager mgr;
+	struct sa_record *r;
+	u64 ring_head = 0;
+	size_t align;
+	uint64_t t;
+	int live = 0;
+
+	memset(sa_records, 0, sizeof(sa_records));
+	align = 1UL << rnd_below(9);
+	if (ring)
+		CHECK(drm_suballoc_manager_init_ring(&mgr, SA_SIZE,
+		    align) == 0);
+	else
+		drm_suballoc_manager_init(&mgr, SA_SIZE, align);
+	shim_wait_hook = sa_wait_hook;
+
+	for (op = 0; op < nops; op++) {
+		r = &sa_records[rnd_below(SA_RECORDS)];
+		switch (rnd_below(8)) {
+		case 0:
+			/* The GPU catches up, in order or not. */
+			if (rnd_below(2))
+				shim_fence_progress();
+			else if (r->fence != NULL)
+				shim_fence_signal(r->fence);
+			break;
+		default:
+			if (r->live) {
+				t = now_ns();
+				sa_free(r);
+				stat_add(&st[SA_FREE], t, false);
+				live--;
+			} else if (!sa_record_busy(r) && live < SA_LIVE) {
+				sa_new(&mgr, r, &ring_head, &st[SA_NEW]);
+				/* The wait hook may have freed some. */
+				live = 0;
+				for (r = sa_records;
+				    r < sa_records + SA_RECORDS; r++)
+					live += r->live;
+			}
+			break;
+		}
+	}
+
+	for (r = sa_records; r < sa_records + SA_RECORDS; r++)
+		if (r->live)
+			sa_free(r);
+	shim_fence_signal_all();
+	for (r = sa_records; r < sa_records + SA_RECORDS; r++)
+		CHECK(!sa_record_busy(r));
+	drm_suballoc_manager_fini(&mgr);
+	shim_wait_hook = NULL;
+	CHECK(shim_errors == 0);
+
+	stat_print(ring ? "sa-ring" : "sa", st, SA_NSTATS);
+}
+
+static void
+usage(void)
+{
+	fprintf(stderr, "usage: alloc_test [-n ops] [-s seed] "
+	    "[-t mm|buddy|sa|sa-ring]\n"
+	    "                  [-w loguniform|uniform|powerlaw|frag|"
+	    "trace:file]\n");
+	exit(2);
+}
+
+int
+main(int argc, char **argv)
+{
+	const char *test = NULL, *workload = "loguniform";
+	uint64_t nops = 100000;
+	int ch;
+
+	seed = now_ns();
+	while ((ch = getopt(argc, argv, "n:s:t:w:")) != -1) {
+		switch (ch) {
+		case 'n':
+			nops = strtoull(optarg, NULL, 0);
+			break;
+		case 's':
+			seed = strtoull(optarg, NULL, 0);
+			break;
+		case 't':
+			test = optarg;
+			break;
+		case 'w':
+			workload = optarg;
+			workload_set(workload);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind != argc)
+		usage();
+
+	printf("seed %" PRIu64 ", workload %s\n", seed, workload);
+	rng = seed ? seed : 1;
+
+	if (test == NULL || strcmp(test, "mm") == 0)
+		test_mm(nops);
+	if (test == NULL || strcmp(test, "buddy") == 0)
+		test_buddy(nops);
+	if (test == NULL || strcmp(test, "sa") == 0)
+		test_sa(nops, false);
+	if (test == NULL || strcmp(test, "sa-ring") == 0)
+		test_sa(nops, true);
+
+	CHECK(shim_fences == 0);
+	CHECK(shim_allocated == 0);
+	return (0);
+}
@@ -0,0 +1,37 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Pre-included on Linux hosts, see the Makefile. drm_mm.c and the shim have
+ * to take their __FreeBSD__ branches, but glibc's headers break when they are
+ * parsed with __FreeBSD__ defined. So every libc header the harness uses is
+ * pulled in first, and only then does the host pose as FreeBSD.
+ */
+
+#ifndef _HOST_LINUX_H_
+#define	_HOST_LINUX_H_
+
+#define	_GNU_SOURCE
+
+#include <sys/param.h>
+#include <sys/types.h>
+
+#include <err.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#undef	__linux__
+#undef	__linux
+#undef	linux
+#define	__FreeBSD__	14
+
+#endif /* _HOST_LINUX_H_ */
@@ -0,0 +1,354 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Stand-in for FreeBSD's <sys/tree.h> on Linux hosts, which don't have one.
+ * Only what the shim's rbtree.h uses: the same RB_* interface and rbe_link[]
+ * layout, classic red-black balancing, and RB_AUGMENT_CHECK() on rotations
+ * and on the path to the root.
+ */
+
+#ifndef _SYS_TREE_H_
+#define _SYS_TREE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define _RB_L	((uintptr_t)1)
+#define _RB_R	((uintptr_t)2)
+#define _RB_LR	((uintptr_t)3)
+#define _RB_BITS(elm)		(*(uintptr_t *)&(elm))
+#define _RB_LINK(elm, dir, field)	(elm)->field.rbe_link[dir]
+#define _RB_UP(elm, field)	_RB_LINK(elm, 0, field)
+#define _RB_PTR(elm)		(__typeof(elm))((uintptr_t)(elm) & ~_RB_LR)
+
+#define RB_HEAD(name, type)	struct name { struct type *rbh_root; }
+#define RB_INITIALIZER(root)	{ NULL }
+#define RB_INIT(root)		do { (root)->rbh_root = NULL; } while (0)
+#define RB_ENTRY(type)		struct { struct type *rbe_link[3]; }
+#define RB_LEFT(elm, field)	_RB_LINK(elm, _RB_L, field)
+#define RB_RIGHT(elm, field)	_RB_LINK(elm, _RB_R, field)
+#define RB_PARENT(elm, field)	_RB_PTR(_RB_UP(elm, field))
+#define RB_ROOT(head)		(head)->rbh_root
+#define RB_EMPTY(head)		(RB_ROOT(head) == NULL)
+#define RB_SET_PARENT(dst, src, field) do {				\
+	_RB_BITS(_RB_UP(dst, field)) = (uintptr_t)(src) |		\
+	    (_RB_BITS(_RB_UP(dst, field)) & _RB_LR);			\
+} while (0)
+#define RB_SET(elm, parent, field) do {					\
+	_RB_UP(elm, field) = (parent);					\
+	RB_LEFT(elm, field) = RB_RIGHT(elm, field) = NULL;		\
+} while (0)
+
+/* bit 0 of the parent link set: red */
+#define _RB_RED(elm, field)	((elm) != NULL && (_RB_BITS(_RB_UP(elm, field)) & 1))
+#define _RB_SETRED(elm, field)	(_RB_BITS(_RB_UP(elm, field)) |= 1)
+#define _RB_SETBLACK(elm, field) (_RB_BITS(_RB_UP(elm, field)) &= ~(uintptr_t)1)
+
+#ifndef RB_AUGMENT_CHECK
+#define RB_AUGMENT_CHECK(x)	0
+#endif
+
+#define RB_PROTOTYPE(name, type, field, cmp)				\
+	RB_PROTOTYPE_INTERNAL(name, type, field, cmp, )
+#define RB_PROTOTYPE_STATIC(name, type, field, cmp)			\
+	RB_PROTOTYPE_INTERNAL(name, type, field, cmp, __attribute__((__unused__)) static)
+#define RB_PROTOTYPE_INTERNAL(name, type, field, cmp, attr)		\
+attr struct type *name##_RB_INSERT_COLOR(struct name *, struct type *, struct type *);\
+attr struct type *name##_RB_REMOVE(struct name *, struct type *);	\
+attr struct type *name##_RB_INSERT(struct name *, struct type *);	\
+attr struct type *name##_RB_NEXT(struct type *);			\
+attr struct type *name##_RB_PREV(struct type *);			\
+attr struct type *name##_RB_MINMAX(struct name *, int);
+
+#define RB_GENERATE(name, type, field, cmp)				\
+	RB_GENERATE_INTERNAL(name, type, field, cmp, )
+#define RB_GENERATE_STATIC(name, type, field, cmp)			\
+	RB_GENERATE_INTERNAL(name, type, field, cmp, __attribute__((__unused__)) static)
+
+#define RB_GENERATE_INTERNAL(name, type, field, cmp, attr)		\
+static void								\
+name##_RB_REPLACE_CHILD(struct name *head, struct type *parent,		\
+    struct type *old, struct type *new)					\
+{									\
+	if (parent == NULL)						\
+		RB_ROOT(head) = new;					\
+	else if (RB_LEFT(parent, field) == old)				\
+		RB_LEFT(parent, field) = new;				\
+	else								\
+		RB_RIGHT(parent, field) = new;				\
+}									\
+									\
+/* Rotate @x down towards @dir, its child from the other side goes up. */\
+static void								\
+name##_RB_ROTATE(struct name *head, struct type *x, int left)		\
+{									\
+	struct type *y, *p = RB_PARENT(x, field);			\
+									\
+	if (left) {							\
+		y = RB_RIGHT(x, field);					\
+		RB_RIGHT(x, field) = RB_LEFT(y, field);			\
+		if (RB_LEFT(y, field) != NULL)				\
+			RB_SET_PARENT(RB_LEFT(y, field), x, field);	\
+		RB_LEFT(y, field) = x;					\
+	} else {							\
+		y = RB_LEFT(x, field);					\
+		RB_LEFT(x, field) = RB_RIGHT(y, field);			\
+		if (RB_RIGHT(y, field) != NULL)				\
+			RB_SET_PARENT(RB_RIGHT(y, field), x, field);	\
+		RB_RIGHT(y, field) = x;					\
+	}								\
+	RB_SET_PARENT(y, p, field);					\
+	name##_RB_REPLACE_CHILD(head, p, x, y);				\
+	RB_SET_PARENT(x, y, field);					\
+	(void)RB_AUGMENT_CHECK(x);					\
+	(void)RB_AUGMENT_CHECK(y);					\
+}									\
+									\
+static void								\
+name##_RB_AUGMENT_WALK(struct type *elm)				\
+{									\
+	for (; elm != NULL; elm = RB_PARENT(elm, field))		\
+		(void)RB_AUGMENT_CHECK(elm);				\
+}									\
+									\
+attr struct type *							\
+name##_RB_INSERT_COLOR(struct name *head, struct type *parent,	\
+    struct type *elm)							\
+{									\
+	struct type *gparent, *uncle;					\
+									\
+	_RB_SETRED(elm, field);						\
+	while ((parent = RB_PARENT(elm, field)) != NULL &&		\
+	    _RB_RED(parent, field)) {					\
+		gparent = RB_PARENT(parent, field);			\
+		if (parent == RB_LEFT(gparent, field)) {		\
+			uncle = RB_RIGHT(gparent, field);		\
+			if (_RB_RED(uncle, field)) {			\
+				_RB_SETBLACK(uncle, field);		\
+				_RB_SETBLACK(parent, field);		\
+				_RB_SETRED(gparent, field);		\
+				elm = gparent;				\
+				continue;				\
+			}						\
+			if (elm == RB_RIGHT(parent, field)) {		\
+				name##_RB_ROTATE(head, parent, 1);	\
+				elm = parent;				\
+				parent = RB_PARENT(elm, field);		\
+			}						\
+			_RB_SETBLACK(parent, field);			\
+			_RB_SETRED(gparent, field);			\
+			name##_RB_ROTATE(head, gparent, 0);		\
+		} else {						\
+			uncle = RB_LEFT(gparent, field);		\
+			if (_RB_RED(uncle, field)) {			\
+				_RB_SETBLACK(uncle, field);		\
+				_RB_SETBLACK(parent, field);		\
+				_RB_SETRED(gparent, field);		\
+				elm = gparent;				\
+				continue;				\
+			}						\
+			if (elm == RB_LEFT(parent, field)) {		\
+				name##_RB_ROTATE(head, parent, 0);	\
+				elm = parent;				\
+				parent = RB_PARENT(elm, field);		\
+			}						\
+			_RB_SETBLACK(parent, field);			\
+			_RB_SETRED(gparent, field);			\
+			name##_RB_ROTATE(head, gparent, 1);		\
+		}							\
+	}								\
+	_RB_SETBLACK(RB_ROOT(head), field);				\
+	return (NULL);							\
+}									\
+									\
+attr struct type *							\
+name##_RB_INSERT(struct name *head, struct type *elm)			\
+{									\
+	struct type **tmpp = &RB_ROOT(head), *parent = NULL;		\
+	int comp;							\
+									\
+	while (*tmpp != NULL) {						\
+		parent = *tmpp;						\
+		comp = cmp(elm, parent);				\
+		if (comp < 0)						\
+			tmpp = &RB_LEFT(parent, field);			\
+		else if (comp > 0)					\
+			tmpp = &RB_RIGHT(parent, field);		\
+		else							\
+			return (parent);				\
+	}								\
+	RB_SET(elm, parent, field);					\
+	*tmpp = elm;							\
+	if (parent != NULL)						\
+		name##_RB_INSERT_COLOR(head, parent, elm);		\
+	name##_RB_AUGMENT_WALK(elm);					\
+	return (NULL);							\
+}									\
+									\
+attr struct type *							\
+name##_RB_REMOVE(struct name *head, struct type *elm)			\
+{									\
+	struct type *child, *parent, *old = elm, *sib, *walk;		\
+	int red;							\
+									\
+	if (RB_LEFT(elm, field) != NULL && RB_RIGHT(elm, field) != NULL) {\
+		/* splice out the successor and put it in elm's place */\
+		struct type *succ = RB_RIGHT(elm, field);		\
+									\
+		while (RB_LEFT(succ, field) != NULL)			\
+			succ = RB_LEFT(succ, field);			\
+		child = RB_RIGHT(succ, field);				\
+		parent = RB_PARENT(succ, field);			\
+		red = _RB_RED(succ, field);				\
+		if (parent == old) {					\
+			parent = succ;					\
+		} else {						\
+			RB_LEFT(parent, field) = child;			\
+			if (child != NULL)				\
+				RB_SET_PARENT(child, parent, field);	\
+			RB_RIGHT(succ, field) = RB_RIGHT(old, field);	\
+			RB_SET_PARENT(RB_RIGHT(old, field), succ, field);\
+		}							\
+		RB_LEFT(succ, field) = RB_LEFT(old, field);		\
+		RB_SET_PARENT(RB_LEFT(old, field), succ, field);	\
+		_RB_UP(succ, field) = _RB_UP(old, field);		\
+		name##_RB_REPLACE_CHILD(head, RB_PARENT(old, field), old,\
+		    succ);						\
+		if (parent == succ)					\
+			RB_RIGHT(succ, field) = child;			\
+	} else {							\
+		child = RB_LEFT(elm, field) != NULL ?			\
+		    RB_LEFT(elm, field) : RB_RIGHT(elm, field);		\
+		parent = RB_PARENT(elm, field);				\
+		red = _RB_RED(elm, field);				\
+		if (child != NULL)					\
+			RB_SET_PARENT(child, parent, field);		\
+		name##_RB_REPLACE_CHILD(head, parent, elm, child);	\
+	}								\
+	walk = parent;							\
+									\
+	if (!red) {							\
+		while (child != RB_ROOT(head) && !_RB_RED(child, field)) {\
+			if (child == RB_LEFT(parent, field)) {		\
+				sib = RB_RIGHT(parent, field);		\
+				if (_RB_RED(sib, field)) {		\
+					_RB_SETBLACK(sib, field);	\
+					_RB_SETRED(parent, field);	\
+					name##_RB_ROTATE(head, parent, 1);\
+					sib = RB_RIGHT(parent, field);	\
+				}					\
+				if (!_RB_RED(RB_LEFT(sib, field), field) &&\
+				    !_RB_RED(RB_RIGHT(sib, field), field)) {\
+					_RB_SETRED(sib, field);		\
+					child = parent;			\
+					parent = RB_PARENT(child, field);\
+					continue;			\
+				}					\
+				if (!_RB_RED(RB_RIGHT(sib, field), field)) {\
+					_RB_SETBLACK(RB_LEFT(sib, field), field);\
+					_RB_SETRED(sib, field);		\
+					name##_RB_ROTATE(head, sib, 0);	\
+					sib = RB_RIGHT(parent, field);	\
+				}					\
+				if (_RB_RED(parent, field))		\
+					_RB_SETRED(sib, field);		\
+				else					\
+					_RB_SETBLACK(sib, field);	\
+				_RB_SETBLACK(parent, field);		\
+				_RB_SETBLACK(RB_RIGHT(sib, field), field);\
+				name##_RB_ROTATE(head, parent, 1);	\
+				child = RB_ROOT(head);			\
+			} else {					\
+				sib = RB_LEFT(parent, field);		\
+				if (_RB_RED(sib, field)) {		\
+					_RB_SETBLACK(sib, field);	\
+					_RB_SETRED(parent, field);	\
+					name##_RB_ROTATE(head, parent, 0);\
+					sib = RB_LEFT(parent, field);	\
+				}					\
+				if (!_RB_RED(RB_LEFT(sib, field), field) &&\
+				    !_RB_RED(RB_RIGHT(sib, field), field)) {\
+					_RB_SETRED(sib, field);		\
+					child = parent;			\
+					parent = RB_PARENT(child, field);\
+					continue;			\
+				}					\
+				if (!_RB_RED(RB_LEFT(sib, field), field)) {\
+					_RB_SETBLACK(RB_RIGHT(sib, field), field);\
+					_RB_SETRED(sib, field);		\
+					name##_RB_ROTATE(head, sib, 1);	\
+					sib = RB_LEFT(parent, field);	\
+				}					\
+				if (_RB_RED(parent, field))		\
+					_RB_SETRED(sib, field);		\
+				else					\
+					_RB_SETBLACK(sib, field);	\
+				_RB_SETBLACK(parent, field);		\
+				_RB_SETBLACK(RB_LEFT(sib, field), field);\
+				name##_RB_ROTATE(head, parent, 0);	\
+				child = RB_ROOT(head);			\
+			}						\
+		}							\
+		if (child != NULL)					\
+			_RB_SETBLACK(child, field);			\
+	}								\
+	name##_RB_AUGMENT_WALK(walk);					\
+	return (old);							\
+}									\
+									\
+attr struct type *							\
+name##_RB_NEXT(struct type *elm)					\
+{									\
+	struct type *p;							\
+									\
+	if (RB_RIGHT(elm, field) != NULL) {				\
+		elm = RB_RIGHT(elm, field);				\
+		while (RB_LEFT(elm, field) != NULL)			\
+			elm = RB_LEFT(elm, field);			\
+		return (elm);						\
+	}								\
+	while ((p = RB_PARENT(elm, field)) != NULL &&			\
+	    elm == RB_RIGHT(p, field))					\
+		elm = p;						\
+	return (p);							\
+}									\
+									\
+attr struct type *							\
+name##_RB_PREV(struct type *elm)					\
+{									\
+	struct type *p;							\
+									\
+	if (RB_LEFT(elm, field) != NULL) {				\
+		elm = RB_LEFT(elm, field);				\
+		while (RB_RIGHT(elm, field) != NULL)			\
+			elm = RB_RIGHT(elm, field);			\
+		return (elm);						\
+	}								\
+	while ((p = RB_PARENT(elm, field)) != NULL &&			\
+	    elm == RB_LEFT(p, field))					\
+		elm = p;						\
+	return (p);							\
+}									\
+									\
+attr struct type *							\
+name##_RB_MINMAX(struct name *head, int val)				\
+{									\
+	struct type *tmp = RB_ROOT(head), *parent = NULL;		\
+									\
+	while (tmp != NULL) {						\
+		parent = tmp;						\
+		tmp = val < 0 ? RB_LEFT(tmp, field) : RB_RIGHT(tmp, field);\
+	}								\
+	return (parent);						\
+}
+
+#define RB_NEGINF	-1
+#define RB_INF		1
+#define RB_INSERT(name, x, y)	name##_RB_INSERT(x, y)
+#define RB_REMOVE(name, x, y)	name##_RB_REMOVE(x, y)
+#define RB_NEXT(name, x, y)	name##_RB_NEXT(y)
+#define RB_PREV(name, x, y)	name##_RB_PREV(y)
+#define RB_MIN(name, x)		name##_RB_MINMAX(x, RB_NEGINF)
+#define RB_MAX(name, x)		name##_RB_MINMAX(x, RB_INF)
+
+#endif /* _SYS_TREE_H_ */
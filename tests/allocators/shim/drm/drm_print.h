@@ -0,0 +1,25 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_DRM_PRINT_H_
+#define	_SHIM_DRM_PRINT_H_
+
+#include <linux/kernel.h>
+
+struct drm_printer {
+	FILE *f;
+};
+
+#define	drm_printf(p, ...)	fprintf((p)->f, __VA_ARGS__)
+#define	drm_puts(p, str)	fputs(str, (p)->f)
+
+extern long shim_errors;
+
+#define	DRM_ERROR(...) do {						\
+	shim_errors++;							\
+	fprintf(stderr, __VA_ARGS__);					\
+} while (0)
+#define	DRM_DEBUG(...)		do { } while (0)
+
+#endif /* _SHIM_DRM_PRINT_H_ */
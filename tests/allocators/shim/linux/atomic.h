@@ -0,0 +1,52 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_ATOMIC_H_
+#define	_SHIM_LINUX_ATOMIC_H_
+
+#include <linux/types.h>
+
+typedef struct {
+	int counter;
+} atomic_t;
+
+typedef struct {
+	s64 counter;
+} atomic64_t;
+
+#define	atomic_read(v)		((v)->counter)
+#define	atomic_set(v, i)	((v)->counter = (i))
+#define	atomic_inc(v)		((v)->counter++)
+#define	atomic_dec(v)		((v)->counter--)
+#define	atomic_dec_and_test(v)	(--(v)->counter == 0)
+
+#define	atomic64_read(v)	((v)->counter)
+#define	atomic64_set(v, i)	((v)->counter = (i))
+#define	atomic64_inc(v)		((v)->counter++)
+#define	atomic64_dec(v)		((v)->counter--)
+#define	atomic64_add(i, v)	((v)->counter += (i))
+#define	atomic64_sub(i, v)	((v)->counter -= (i))
+
+static inline s64
+atomic64_cmpxchg(atomic64_t *v, s64 old, s64 new)
+{
+	s64 cur = v->counter;
+
+	if (cur == old)
+		v->counter = new;
+	return (cur);
+}
+
+#define	test_bit(nr, addr)						\
+	((((const unsigned long *)(addr))[(nr) / LONG_BIT] >>		\
+	    ((nr) % LONG_BIT)) & 1)
+#define	__set_bit(nr, addr)						\
+	(((unsigned long *)(addr))[(nr) / LONG_BIT] |= 1UL << ((nr) % LONG_BIT))
+#define	__clear_bit(nr, addr)						\
+	(((unsigned long *)(addr))[(nr) / LONG_BIT] &= ~(1UL << ((nr) % LONG_BIT)))
+#define	set_bit(nr, addr)		__set_bit(nr, addr)
+#define	clear_bit(nr, addr)		__clear_bit(nr, addr)
+#define	clear_bit_unlock(nr, addr)	__clear_bit(nr, addr)
+
+#endif /* _SHIM_LINUX_ATOMIC_H_ */
@@ -0,0 +1,41 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_BUG_H_
+#define	_SHIM_LINUX_BUG_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Any warning fails the run, the allocators must never trigger one. */
+#define	BUG() do {							\
+	fprintf(stderr, "BUG at %s:%d\n", __FILE__, __LINE__);		\
+	abort();							\
+} while (0)
+#define	BUG_ON(cond) do {						\
+	if (__builtin_expect(!!(cond), 0))				\
+		BUG();							\
+} while (0)
+#define	WARN_ON(cond) ({						\
+	int __ret_warn = !!(cond);					\
+	if (__builtin_expect(__ret_warn, 0)) {				\
+		fprintf(stderr, "WARN_ON(%s) at %s:%d\n", #cond,	\
+		    __FILE__, __LINE__);				\
+		abort();						\
+	}								\
+	__ret_warn;							\
+})
+#define	WARN_ON_ONCE(cond)	WARN_ON(cond)
+#define	WARN(cond, ...) ({						\
+	int __ret_warn = !!(cond);					\
+	if (__builtin_expect(__ret_warn, 0)) {				\
+		fprintf(stderr, __VA_ARGS__);				\
+		abort();						\
+	}								\
+	__ret_warn;							\
+})
+#define	BUILD_BUG_ON_INVALID(e)	((void)sizeof((long)(e)))
+#define	BUILD_BUG_ON(cond)	_Static_assert(!(cond), #cond)
+
+#endif /* _SHIM_LINUX_BUG_H_ */
@@ -0,0 +1,24 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_COMPILER_H_
+#define	_SHIM_LINUX_COMPILER_H_
+
+#define	likely(x)		__builtin_expect(!!(x), 1)
+#define	unlikely(x)		__builtin_expect(!!(x), 0)
+#define	typeof(x)		__typeof(x)
+#define	READ_ONCE(x)		(*(volatile __typeof(x) *)&(x))
+#define	WRITE_ONCE(x, v)	(*(volatile __typeof(x) *)&(x) = (v))
+#define	barrier()		__asm__ __volatile__("" : : : "memory")
+#define	smp_mb()		barrier()
+#define	smp_wmb()		barrier()
+#define	smp_rmb()		barrier()
+#define	fallthrough		__attribute__((__fallthrough__))
+#define	__always_inline		inline __attribute__((__always_inline__))
+#define	__must_check		__attribute__((__warn_unused_result__))
+#define	__maybe_unused		__attribute__((__unused__))
+#define	__force
+#define	____cacheline_aligned_in_smp
+
+#endif /* _SHIM_LINUX_COMPILER_H_ */
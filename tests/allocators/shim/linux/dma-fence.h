@@ -0,0 +1,76 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Fences are created and signaled by the harness, see shim.c.
+ */
+
+#ifndef _SHIM_LINUX_DMA_FENCE_H_
+#define	_SHIM_LINUX_DMA_FENCE_H_
+
+#include <linux/kernel.h>
+#include <linux/list.h>
+#include <linux/sched.h>
+#include <linux/wait.h>
+
+struct dma_fence;
+struct dma_fence_cb;
+
+typedef void (*dma_fence_func_t)(struct dma_fence *fence,
+    struct dma_fence_cb *cb);
+
+struct dma_fence_cb {
+	struct list_head node;
+	dma_fence_func_t func;
+};
+
+struct dma_fence {
+	int refcount;
+	bool signaled;
+	u64 context;
+	u64 seqno;
+	struct list_head cb_list;
+	struct list_head pending;	/* shim: in the signal FIFO */
+};
+
+struct dma_fence *shim_fence_create(u64 context);
+void shim_fence_signal(struct dma_fence *fence);
+void shim_fence_free(struct dma_fence *fence);
+
+static inline struct dma_fence *
+dma_fence_get(struct dma_fence *fence)
+{
+	if (fence != NULL)
+		fence->refcount++;
+	return (fence);
+}
+
+static inline void
+dma_fence_put(struct dma_fence *fence)
+{
+	if (fence != NULL && --fence->refcount == 0)
+		shim_fence_free(fence);
+}
+
+static inline bool
+dma_fence_is_signaled(struct dma_fence *fence)
+{
+	return (fence->signaled);
+}
+
+static inline int
+dma_fence_add_callback(struct dma_fence *fence, struct dma_fence_cb *cb,
+    dma_fence_func_t func)
+{
+	if (fence->signaled) {
+		INIT_LIST_HEAD(&cb->node);
+		return (-ENOENT);
+	}
+	cb->func = func;
+	list_add_tail(&cb->node, &fence->cb_list);
+	return (0);
+}
+
+long dma_fence_wait_any_timeout(struct dma_fence **fences, uint32_t count,
+    bool intr, long timeout, uint32_t *idx);
+
+#endif /* _SHIM_LINUX_DMA_FENCE_H_ */
@@ -0,0 +1,72 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * linuxkpi's interval tree: a plain tree sorted by start, searched linearly,
+ * the subtree field is left to the caller.
+ */
+
+#ifndef _SHIM_LINUX_INTERVAL_TREE_GENERIC_H_
+#define	_SHIM_LINUX_INTERVAL_TREE_GENERIC_H_
+
+#include <linux/rbtree.h>
+
+#define	INTERVAL_TREE_DEFINE(type, field, valtype, dummy, START, LAST,	\
+    attr, name)								\
+static inline type *							\
+name##_iter_from(struct rb_node *rb, valtype start, valtype last)	\
+{									\
+	type *node;							\
+									\
+	while (rb != NULL) {						\
+		node = rb_entry(rb, type, field);			\
+		if (LAST(node) >= start && START(node) <= last)		\
+			return (node);					\
+		else if (START(node) > last)				\
+			break;						\
+		rb = rb_next(rb);					\
+	}								\
+	return (NULL);							\
+}									\
+									\
+attr type *								\
+name##_iter_first(struct rb_root_cached *root, valtype start,		\
+    valtype last)							\
+{									\
+	return (name##_iter_from(rb_first_cached(root), start, last));	\
+}									\
+									\
+attr type *								\
+name##_iter_next(type *node, valtype start, valtype last)		\
+{									\
+	return (name##_iter_from(rb_next(&node->field), start, last));	\
+}									\
+									\
+attr void								\
+name##_insert(type *node, struct rb_root_cached *root)			\
+{									\
+	struct rb_node **iter = &root->rb_root.rb_node;			\
+	struct rb_node *parent = NULL;					\
+	type *iter_node;						\
+	bool min_entry = true;						\
+									\
+	while (*iter != NULL) {						\
+		parent = *iter;						\
+		iter_node = rb_entry(parent, type, field);		\
+		if (START(node) < START(iter_node))			\
+			iter = &parent->rb_left;			\
+		else {							\
+			iter = &parent->rb_right;			\
+			min_entry = false;				\
+		}							\
+	}								\
+	rb_link_node(&node->field, parent, iter);			\
+	rb_insert_color_cached(&node->field, root, min_entry);		\
+}									\
+									\
+attr void								\
+name##_remove(type *node, struct rb_root_cached *root)			\
+{									\
+	rb_erase_cached(&node->field, root);				\
+}
+
+#endif /* _SHIM_LINUX_INTERVAL_TREE_GENERIC_H_ */
@@ -0,0 +1,100 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Just enough of linuxkpi to build drm_mm.c, drm_buddy.c and drm_suballoc.c
+ * as a single threaded userland program. Anything the allocators only need
+ * for SMP safety (locks, barriers, atomics) is a plain, non-atomic operation.
+ */
+
+#ifndef _SHIM_LINUX_KERNEL_H_
+#define	_SHIM_LINUX_KERNEL_H_
+
+#include <sys/param.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <linux/types.h>
+#include <linux/compiler.h>
+#include <linux/bug.h>
+#include <linux/atomic.h>
+#include <linux/log2.h>
+
+#undef min
+#undef max
+#define	min(x, y)	((x) < (y) ? (x) : (y))
+#define	max(x, y)	((x) > (y) ? (x) : (y))
+#define	min3(a, b, c)	min(a, min(b, c))
+#define	min_t(t, x, y)	((t)(x) < (t)(y) ? (t)(x) : (t)(y))
+#define	max_t(t, x, y)	((t)(x) > (t)(y) ? (t)(x) : (t)(y))
+#define	clamp(v, lo, hi)	min(max(v, lo), hi)
+#define	swap(a, b) do {							\
+	__typeof(a) __swap_tmp = (a);					\
+	(a) = (b);							\
+	(b) = __swap_tmp;						\
+} while (0)
+
+#ifndef ARRAY_SIZE
+#define	ARRAY_SIZE(x)	(sizeof(x) / sizeof((x)[0]))
+#endif
+#define	container_of(ptr, type, member)					\
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#undef ALIGN
+#define	ALIGN(x, a)		round_up(x, a)
+#define	IS_ALIGNED(x, a)	(((x) & ((__typeof(x))(a) - 1)) == 0)
+#undef round_up
+#undef round_down
+#define	round_up(x, y)		((((x) - 1) | ((__typeof(x))(y) - 1)) + 1)
+#define	round_down(x, y)	((x) & ~((__typeof(x))(y) - 1))
+#define	DIV_ROUND_UP(n, d)	(((n) + (d) - 1) / (d))
+
+#define	U32_MAX		((u32)~0U)
+#define	U64_MAX		((u64)~0ULL)
+#define	S64_MAX		((s64)(U64_MAX >> 1))
+
+#define	BIT(n)		(1UL << (n))
+#define	BIT_ULL(n)	(1ULL << (n))
+#define	GENMASK_ULL(h, l)						\
+	(((~0ULL) >> (63 - (h))) & ((~0ULL) << (l)))
+
+#define	EXPORT_SYMBOL(sym)
+#define	EXPORT_SYMBOL_GPL(sym)
+#define	MODULE_AUTHOR(x)
+#define	MODULE_DESCRIPTION(x)
+#define	MODULE_LICENSE(x)
+#define	module_init(fn)							\
+	static void __attribute__((constructor)) __shim_init_##fn(void)	\
+	{ (void)fn(); }
+#define	module_exit(fn)							\
+	static void __attribute__((destructor)) __shim_exit_##fn(void)	\
+	{ fn(); }
+#define	__init
+#define	__exit
+
+#define	MAX_ERRNO	4095
+#define	IS_ERR_VALUE(x)	((unsigned long)(x) >= (unsigned long)-MAX_ERRNO)
+#define	ERR_PTR(err)	((void *)(long)(err))
+#define	PTR_ERR(ptr)	((long)(ptr))
+#define	IS_ERR(ptr)	IS_ERR_VALUE(ptr)
+
+#define	might_sleep()		do { } while (0)
+#define	cond_resched()		do { } while (0)
+#define	lockdep_assert_held(l)	do { (void)(l); } while (0)
+
+#define	nr_cpu_ids		1U
+#define	smp_processor_id()	0U
+#define	raw_smp_processor_id()	0U
+#define	get_cpu()		0U
+#define	put_cpu()		do { } while (0)
+
+#define	pr_err(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define	pr_warn(fmt, ...)	fprintf(stderr, fmt, ##__VA_ARGS__)
+#define	pr_info(fmt, ...)	printf(fmt, ##__VA_ARGS__)
+
+#include <linux/math64.h>
+
+#endif /* _SHIM_LINUX_KERNEL_H_ */
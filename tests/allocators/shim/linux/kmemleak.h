@@ -0,0 +1,12 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_KMEMLEAK_H_
+#define	_SHIM_LINUX_KMEMLEAK_H_
+
+#include <linux/kernel.h>
+
+#define	kmemleak_update_trace(ptr)	do { } while (0)
+
+#endif /* _SHIM_LINUX_KMEMLEAK_H_ */
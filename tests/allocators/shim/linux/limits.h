@@ -0,0 +1,10 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_LIMITS_H_
+#define	_SHIM_LINUX_LIMITS_H_
+
+#include <linux/kernel.h>
+
+#endif /* _SHIM_LINUX_LIMITS_H_ */
@@ -0,0 +1,188 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_LIST_H_
+#define	_SHIM_LINUX_LIST_H_
+
+#include <linux/kernel.h>
+
+#define	LIST_HEAD_INIT(name)	{ &(name), &(name) }
+#define	LIST_HEAD(name)		struct list_head name = LIST_HEAD_INIT(name)
+
+static inline void
+INIT_LIST_HEAD(struct list_head *list)
+{
+	list->next = list->prev = list;
+}
+
+static inline bool
+list_empty(const struct list_head *head)
+{
+	return (head->next == head);
+}
+
+static inline bool
+list_is_singular(const struct list_head *head)
+{
+	return (!list_empty(head) && head->next == head->prev);
+}
+
+static inline void
+__list_add(struct list_head *new, struct list_head *prev,
+    struct list_head *next)
+{
+	next->prev = new;
+	new->next = next;
+	new->prev = prev;
+	prev->next = new;
+}
+
+static inline void
+list_add(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head, head->next);
+}
+
+static inline void
+list_add_tail(struct list_head *new, struct list_head *head)
+{
+	__list_add(new, head->prev, head);
+}
+
+static inline void
+__list_del(struct list_head *prev, struct list_head *next)
+{
+	next->prev = prev;
+	prev->next = next;
+}
+
+static inline void
+__list_del_entry(struct list_head *entry)
+{
+	__list_del(entry->prev, entry->next);
+}
+
+static inline void
+list_del(struct list_head *entry)
+{
+	__list_del_entry(entry);
+	entry->next = entry->prev = NULL;
+}
+
+static inline void
+list_del_init(struct list_head *entry)
+{
+	__list_del_entry(entry);
+	INIT_LIST_HEAD(entry);
+}
+
+static inline void
+list_move(struct list_head *list, struct list_head *head)
+{
+	__list_del_entry(list);
+	list_add(list, head);
+}
+
+static inline void
+list_move_tail(struct list_head *list, struct list_head *head)
+{
+	__list_del_entry(list);
+	list_add_tail(list, head);
+}
+
+static inline void
+__list_splice(const struct list_head *list, struct list_head *prev,
+    struct list_head *next)
+{
+	struct list_head *first = list->next;
+	struct list_head *last = list->prev;
+
+	first->prev = prev;
+	prev->next = first;
+	last->next = next;
+	next->prev = last;
+}
+
+static inline void
+list_splice(const struct list_head *list, struct list_head *head)
+{
+	if (!list_empty(list))
+		__list_splice(list, head, head->next);
+}
+
+static inline void
+list_splice_tail(const struct list_head *list, struct list_head *head)
+{
+	if (!list_empty(list))
+		__list_splice(list, head->prev, head);
+}
+
+static inline void
+list_splice_init(struct list_head *list, struct list_head *head)
+{
+	if (!list_empty(list)) {
+		__list_splice(list, head, head->next);
+		INIT_LIST_HEAD(list);
+	}
+}
+
+static inline void
+list_splice_tail_init(struct list_head *list, struct list_head *head)
+{
+	if (!list_empty(list)) {
+		__list_splice(list, head->prev, head);
+		INIT_LIST_HEAD(list);
+	}
+}
+
+#define	list_entry(ptr, type, member)	container_of(ptr, type, member)
+#define	list_first_entry(ptr, type, member)				\
+	list_entry((ptr)->next, type, member)
+#define	list_last_entry(ptr, type, member)				\
+	list_entry((ptr)->prev, type, member)
+#define	list_first_entry_or_null(ptr, type, member)			\
+	(!list_empty(ptr) ? list_first_entry(ptr, type, member) : NULL)
+#define	list_next_entry(pos, member)					\
+	list_entry((pos)->member.next, __typeof(*(pos)), member)
+#define	list_prev_entry(pos, member)					\
+	list_entry((pos)->member.prev, __typeof(*(pos)), member)
+#define	list_entry_is_head(pos, head, member)				\
+	(&(pos)->member == (head))
+
+#define	list_for_each(p, head)						\
+	for ((p) = (head)->next; (p) != (head); (p) = (p)->next)
+#define	list_for_each_safe(p, n, head)					\
+	for ((p) = (head)->next, (n) = (p)->next; (p) != (head);	\
+	    (p) = (n), (n) = (p)->next)
+#define	list_for_each_entry(pos, head, member)				\
+	for ((pos) = list_first_entry(head, __typeof(*(pos)), member);	\
+	    !list_entry_is_head(pos, head, member);			\
+	    (pos) = list_next_entry(pos, member))
+#define	list_for_each_entry_reverse(pos, head, member)			\
+	for ((pos) = list_last_entry(head, __typeof(*(pos)), member);	\
+	    !list_entry_is_head(pos, head, member);			\
+	    (pos) = list_prev_entry(pos, member))
+#define	list_for_each_entry_continue(pos, head, member)			\
+	for ((pos) = list_next_entry(pos, member);			\
+	    !list_entry_is_head(pos, head, member);			\
+	    (pos) = list_next_entry(pos, member))
+#define	list_for_each_entry_from(pos, head, member)			\
+	for (; !list_entry_is_head(pos, head, member);			\
+	    (pos) = list_next_entry(pos, member))
+#define	list_for_each_entry_safe(pos, n, head, member)			\
+	for ((pos) = list_first_entry(head, __typeof(*(pos)), member),	\
+	    (n) = list_next_entry(pos, member);				\
+	    !list_entry_is_head(pos, head, member);			\
+	    (pos) = (n), (n) = list_next_entry(n, member))
+#define	list_for_each_entry_safe_from(pos, n, head, member)		\
+	for ((n) = list_next_entry(pos, member);			\
+	    !list_entry_is_head(pos, head, member);			\
+	    (pos) = (n), (n) = list_next_entry(n, member))
+#define	list_for_each_entry_safe_reverse(pos, n, head, member)		\
+	for ((pos) = list_last_entry(head, __typeof(*(pos)), member),	\
+	    (n) = list_prev_entry(pos, member);				\
+	    !list_entry_is_head(pos, head, member);			\
+	    (pos) = (n), (n) = list_prev_entry(n, member))
+
+#endif /* _SHIM_LINUX_LIST_H_ */
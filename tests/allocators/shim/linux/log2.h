@@ -0,0 +1,23 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_LOG2_H_
+#define	_SHIM_LINUX_LOG2_H_
+
+#include <linux/types.h>
+
+#define	ilog2(n)	((int)(63 - __builtin_clzll((u64)(n))))
+#define	is_power_of_2(n)	((n) != 0 && (((n) & ((n) - 1)) == 0))
+#define	roundup_pow_of_two(n)						\
+	((n) <= 1 ? (__typeof(n))1 : (__typeof(n))(1ULL << (ilog2((n) - 1) + 1)))
+#define	rounddown_pow_of_two(n)	((__typeof(n))(1ULL << ilog2(n)))
+#define	__ffs(x)	((unsigned long)__builtin_ctzl(x))
+#define	__fls(x)	((unsigned long)(63 - __builtin_clzl(x)))
+#define	__ffs64(x)	((unsigned long)__builtin_ctzll(x))
+#define	fls64(x)	((x) ? 64 - __builtin_clzll(x) : 0)
+#define	hweight64(x)	((unsigned int)__builtin_popcountll(x))
+#define	fls(x)		((x) ? 32 - __builtin_clz((unsigned int)(x)) : 0)
+#define	hweight32(x)	((unsigned int)__builtin_popcount(x))
+
+#endif /* _SHIM_LINUX_LOG2_H_ */
@@ -0,0 +1,42 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_MATH64_H_
+#define	_SHIM_LINUX_MATH64_H_
+
+#include <linux/kernel.h>
+
+static inline u64
+div64_u64_rem(u64 dividend, u64 divisor, u64 *remainder)
+{
+	*remainder = dividend % divisor;
+	return (dividend / divisor);
+}
+
+static inline u64
+div64_u64(u64 dividend, u64 divisor)
+{
+	return (dividend / divisor);
+}
+
+static inline u64
+div_u64_rem(u64 dividend, u32 divisor, u32 *remainder)
+{
+	*remainder = dividend % divisor;
+	return (dividend / divisor);
+}
+
+static inline u64
+div_u64(u64 dividend, u32 divisor)
+{
+	return (dividend / divisor);
+}
+
+#define	do_div(n, base) ({						\
+	u32 __rem = (u32)((n) % (base));				\
+	(n) /= (base);							\
+	__rem;								\
+})
+
+#endif /* _SHIM_LINUX_MATH64_H_ */
@@ -0,0 +1,33 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_OVERFLOW_H_
+#define	_SHIM_LINUX_OVERFLOW_H_
+
+#include <linux/kernel.h>
+
+#define	check_add_overflow(a, b, d)	__builtin_add_overflow(a, b, d)
+#define	check_sub_overflow(a, b, d)	__builtin_sub_overflow(a, b, d)
+#define	check_mul_overflow(a, b, d)	__builtin_mul_overflow(a, b, d)
+
+static inline size_t
+size_mul(size_t a, size_t b)
+{
+	size_t r;
+
+	return (__builtin_mul_overflow(a, b, &r) ? SIZE_MAX : r);
+}
+
+static inline size_t
+size_add(size_t a, size_t b)
+{
+	size_t r;
+
+	return (__builtin_add_overflow(a, b, &r) ? SIZE_MAX : r);
+}
+
+#define	struct_size(p, member, count)					\
+	size_add(sizeof(*(p)), size_mul(sizeof(*(p)->member), count))
+
+#endif /* _SHIM_LINUX_OVERFLOW_H_ */
@@ -0,0 +1,94 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Linux red-black trees on top of <sys/tree.h>, laid out like linuxkpi's so
+ * that the FreeBSD branches of drm_mm.c are the ones being exercised.
+ */
+
+#ifndef _SHIM_LINUX_RBTREE_H_
+#define	_SHIM_LINUX_RBTREE_H_
+
+#include <sys/tree.h>
+
+#include <linux/kernel.h>
+
+struct rb_node {
+	RB_ENTRY(rb_node) __entry;
+};
+#define	rb_left		__entry.rbe_link[_RB_L]
+#define	rb_right	__entry.rbe_link[_RB_R]
+
+struct rb_root {
+	struct rb_node *rb_node;
+};
+
+struct rb_root_cached {
+	struct rb_root rb_root;
+	struct rb_node *rb_leftmost;
+};
+
+RB_HEAD(linux_root, rb_node);
+RB_PROTOTYPE(linux_root, rb_node, __entry, panic_cmp);
+
+#define	rb_parent(r)	RB_PARENT(r, __entry)
+#define	rb_entry(ptr, type, member)	container_of(ptr, type, member)
+#define	rb_entry_safe(ptr, type, member) ({				\
+	__typeof(ptr) ____ptr = (ptr);					\
+	____ptr ? rb_entry(____ptr, type, member) : NULL;		\
+})
+
+#define	RB_EMPTY_ROOT(root)	((root)->rb_node == NULL)
+#define	RB_EMPTY_NODE(node)	(RB_PARENT(node, __entry) == node)
+#define	RB_CLEAR_NODE(node)	RB_SET_PARENT(node, node, __entry)
+
+#define	rb_erase(node, root)						\
+	linux_root_RB_REMOVE((struct linux_root *)(root), (node))
+#define	rb_next(node)	RB_NEXT(linux_root, NULL, (node))
+#define	rb_prev(node)	RB_PREV(linux_root, NULL, (node))
+#define	rb_first(root)	RB_MIN(linux_root, (struct linux_root *)(root))
+#define	rb_last(root)	RB_MAX(linux_root, (struct linux_root *)(root))
+#define	rb_first_cached(root)	(root)->rb_leftmost
+
+#undef RB_ROOT
+#define	RB_ROOT		(struct rb_root) { NULL }
+#define	RB_ROOT_CACHED	(struct rb_root_cached) { RB_ROOT, NULL }
+
+static inline void
+rb_link_node(struct rb_node *node, struct rb_node *parent,
+    struct rb_node **rb_link)
+{
+	RB_SET(node, parent, __entry);
+	*rb_link = node;
+}
+
+static inline void
+rb_insert_color(struct rb_node *node, struct rb_root *root)
+{
+	if (rb_parent(node))
+		linux_root_RB_INSERT_COLOR((struct linux_root *)root,
+		    rb_parent(node), node);
+}
+
+static inline void
+rb_insert_color_cached(struct rb_node *node, struct rb_root_cached *root,
+    bool leftmost)
+{
+	rb_insert_color(node, &root->rb_root);
+	if (leftmost)
+		root->rb_leftmost = node;
+}
+
+static inline struct rb_node *
+rb_erase_cached(struct rb_node *node, struct rb_root_cached *root)
+{
+	struct rb_node *retval;
+
+	if (node == root->rb_leftmost)
+		retval = root->rb_leftmost = rb_next(node);
+	else
+		retval = NULL;
+	rb_erase(node, &root->rb_root);
+	return (retval);
+}
+
+#endif /* _SHIM_LINUX_RBTREE_H_ */
@@ -0,0 +1,15 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_SCHED_H_
+#define	_SHIM_LINUX_SCHED_H_
+
+#include <linux/kernel.h>
+
+#define	MAX_SCHEDULE_TIMEOUT	LONG_MAX
+
+#define	signal_pending(task)	false
+#define	fatal_signal_pending(task) false
+
+#endif /* _SHIM_LINUX_SCHED_H_ */
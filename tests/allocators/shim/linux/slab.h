@@ -0,0 +1,57 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_SLAB_H_
+#define	_SHIM_LINUX_SLAB_H_
+
+#include <linux/kernel.h>
+#include <linux/overflow.h>
+
+#define	GFP_KERNEL	0x0001U
+#define	GFP_NOWAIT	0x0002U
+#define	GFP_ATOMIC	0x0004U
+#define	__GFP_ZERO	0x0100U
+#define	__GFP_NOWARN	0x0200U
+#define	__GFP_RETRY_MAYFAIL 0x0400U
+
+void *shim_malloc(size_t size, gfp_t gfp);
+void shim_free(const void *ptr);
+
+#define	kmalloc(size, gfp)	shim_malloc(size, gfp)
+#define	kzalloc(size, gfp)	shim_malloc(size, (gfp) | __GFP_ZERO)
+#define	kvmalloc(size, gfp)	kmalloc(size, gfp)
+#define	kvzalloc(size, gfp)	kzalloc(size, gfp)
+#define	kmalloc_array(n, size, gfp)					\
+	kmalloc(size_mul(n, size), gfp)
+#define	kvmalloc_array(n, size, gfp)	kmalloc_array(n, size, gfp)
+#define	kcalloc(n, size, gfp)	kzalloc(size_mul(n, size), gfp)
+#define	kfree(ptr)		shim_free(ptr)
+#define	kvfree(ptr)		shim_free(ptr)
+
+struct kmem_cache {
+	size_t size;
+};
+
+#define	SLAB_HWCACHE_ALIGN	0x1U
+
+#define	KMEM_CACHE(s, flags)						\
+	kmem_cache_create(#s, sizeof(struct s), 0, flags, NULL)
+
+static inline struct kmem_cache *
+kmem_cache_create(const char *name, size_t size, size_t align,
+    unsigned long flags, void (*ctor)(void *))
+{
+	struct kmem_cache *c = malloc(sizeof(*c));
+
+	if (c != NULL)
+		c->size = size;
+	return (c);
+}
+
+#define	kmem_cache_alloc(c, gfp)	shim_malloc((c)->size, gfp)
+#define	kmem_cache_zalloc(c, gfp)	shim_malloc((c)->size, (gfp) | __GFP_ZERO)
+#define	kmem_cache_free(c, ptr)		shim_free(ptr)
+#define	kmem_cache_destroy(c)		free(c)
+
+#endif /* _SHIM_LINUX_SLAB_H_ */
@@ -0,0 +1,39 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_SPINLOCK_H_
+#define	_SHIM_LINUX_SPINLOCK_H_
+
+#include <linux/kernel.h>
+
+/* Single threaded: a lock only tracks that it's held, to catch recursion. */
+typedef struct {
+	int locked;
+} spinlock_t;
+
+#define	DEFINE_SPINLOCK(name)	spinlock_t name = { 0 }
+#define	spin_lock_init(l)	((l)->locked = 0)
+#define	spin_lock(l)		BUG_ON((l)->locked++)
+#define	spin_unlock(l)		BUG_ON(--(l)->locked)
+#define	spin_lock_irqsave(l, flags) do {				\
+	(flags) = 0;							\
+	spin_lock(l);							\
+} while (0)
+#define	spin_unlock_irqrestore(l, flags) do {				\
+	(void)(flags);							\
+	spin_unlock(l);							\
+} while (0)
+#define	spin_lock_irq(l)	spin_lock(l)
+#define	spin_unlock_irq(l)	spin_unlock(l)
+
+struct mutex {
+	int locked;
+};
+
+#define	mutex_init(m)		((m)->locked = 0)
+#define	mutex_lock(m)		BUG_ON((m)->locked++)
+#define	mutex_unlock(m)		BUG_ON(--(m)->locked)
+#define	mutex_destroy(m)	BUG_ON((m)->locked)
+
+#endif /* _SHIM_LINUX_SPINLOCK_H_ */
@@ -0,0 +1,10 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_STACKTRACE_H_
+#define	_SHIM_LINUX_STACKTRACE_H_
+
+#include <linux/kernel.h>
+
+#endif /* _SHIM_LINUX_STACKTRACE_H_ */
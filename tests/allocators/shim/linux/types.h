@@ -0,0 +1,38 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef _SHIM_LINUX_TYPES_H_
+#define	_SHIM_LINUX_TYPES_H_
+
+#include <sys/types.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef unsigned long long u64;
+typedef int8_t		s8;
+typedef int16_t		s16;
+typedef int32_t		s32;
+typedef long long	s64;
+typedef uint8_t		__u8;
+typedef uint16_t	__u16;
+typedef uint32_t	__u32;
+typedef u64		__u64;
+typedef int32_t		__s32;
+typedef s64		__s64;
+
+typedef unsigned int	gfp_t;
+typedef u64		phys_addr_t;
+typedef u64		resource_size_t;
+typedef s64		ktime_t;
+
+struct list_head {
+	struct list_head *next;
+	struct list_head *prev;
+};
+
+#endif /* _SHIM_LINUX_TYPES_H_ */
@@ -0,0 +1,45 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Nothing ever sleeps: a wait that can't be satisfied right away lets the
+ * "GPU" make progress by signaling the oldest pending fence instead, and
+ * fails the run if there's none left, since the waiter would hang forever.
+ */
+
+#ifndef _SHIM_LINUX_WAIT_H_
+#define	_SHIM_LINUX_WAIT_H_
+
+#include <linux/kernel.h>
+#include <linux/spinlock.h>
+
+typedef struct wait_queue_head {
+	spinlock_t lock;
+} wait_queue_head_t;
+
+void shim_wait_progress(const char *what);
+
+#define	init_waitqueue_head(wq)		spin_lock_init(&(wq)->lock)
+#define	waitqueue_active(wq)		true
+#define	wake_up_all(wq)			do { (void)(wq); } while (0)
+#define	wake_up_all_locked(wq)		do { (void)(wq); } while (0)
+
+#define	wait_event(wq, cond) do {					\
+	while (!(cond))							\
+		shim_wait_progress(#cond);				\
+} while (0)
+
+#define	wait_event_interruptible(wq, cond) ({				\
+	wait_event(wq, cond);						\
+	0;								\
+})
+
+#define	wait_event_interruptible_locked(wq, cond) ({			\
+	while (!(cond)) {						\
+		spin_unlock(&(wq).lock);				\
+		shim_wait_progress(#cond);				\
+		spin_lock(&(wq).lock);					\
+	}								\
+	0;								\
+})
+
+#endif /* _SHIM_LINUX_WAIT_H_ */
@@ -0,0 +1,139 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <linux/dma-fence.h>
+#include <linux/rbtree.h>
+#include <linux/slab.h>
+#include <linux/wait.h>
+
+#include "shim.h"
+
+static int
+panic_cmp(struct rb_node *one, struct rb_node *two)
+{
+	BUG();
+}
+
+/* As in linux_compat.c, RB_ROOT is Linux's initializer otherwise. */
+#undef RB_ROOT
+#define	RB_ROOT(head)	(head)->rbh_root
+RB_GENERATE(linux_root, rb_node, __entry, panic_cmp);
+
+long shim_allocated;
+long shim_errors;
+
+void *
+shim_malloc(size_t size, gfp_t gfp)
+{
+	void *ptr;
+
+	ptr = (gfp & __GFP_ZERO) ? calloc(1, size) : malloc(size);
+	if (ptr != NULL)
+		shim_allocated++;
+	return (ptr);
+}
+
+void
+shim_free(const void *ptr)
+{
+	if (ptr != NULL)
+		shim_allocated--;
+	free((void *)ptr);
+}
+
+/* Unsignaled fences, in the order the harness created them. */
+static LIST_HEAD(shim_fence_fifo);
+long shim_fences;
+
+struct dma_fence *
+shim_fence_create(u64 context)
+{
+	static u64 seqno;
+	struct dma_fence *fence;
+
+	fence = calloc(1, sizeof(*fence));
+	BUG_ON(fence == NULL);
+	/* One reference for the caller, one for the FIFO. */
+	fence->refcount = 2;
+	fence->context = context;
+	fence->seqno = ++seqno;
+	INIT_LIST_HEAD(&fence->cb_list);
+	list_add_tail(&fence->pending, &shim_fence_fifo);
+	shim_fences++;
+	return (fence);
+}
+
+void
+shim_fence_signal(struct dma_fence *fence)
+{
+	struct dma_fence_cb *cb, *tmp;
+
+	if (fence->signaled)
+		return;
+
+	fence->signaled = true;
+	list_del(&fence->pending);
+	list_for_each_entry_safe(cb, tmp, &fence->cb_list, node) {
+		list_del_init(&cb->node);
+		cb->func(fence, cb);
+	}
+	dma_fence_put(fence);
+}
+
+void
+shim_fence_free(struct dma_fence *fence)
+{
+	BUG_ON(!fence->signaled);
+	shim_fences--;
+	free(fence);
+}
+
+bool
+shim_fence_progress(void)
+{
+	if (list_empty(&shim_fence_fifo))
+		return (false);
+
+	shim_fence_signal(list_first_entry(&shim_fence_fifo,
+	    struct dma_fence, pending));
+	return (true);
+}
+
+void
+shim_fence_signal_all(void)
+{
+	while (shim_fence_progress())
+		;
+}
+
+bool (*shim_wait_hook)(void);
+
+void
+shim_wait_progress(const char *what)
+{
+	if (!shim_fence_progress() &&
+	    (shim_wait_hook == NULL || !shim_wait_hook())) {
+		fprintf(stderr, "deadlock: waiting for %s with nothing "
+		    "left to free or signal\n", what);
+		abort();
+	}
+}
+
+long
+dma_fence_wait_any_timeout(struct dma_fence **fences, uint32_t count,
+    bool intr, long timeout, uint32_t *idx)
+{
+	uint32_t i;
+
+	for (;;) {
+		for (i = 0; i < count; i++) {
+			if (fences[i]->signaled) {
+				if (idx != NULL)
+					*idx = i;
+				return (timeout ? timeout : 1);
+			}
+		}
+		shim_wait_progress("dma_fence_wait_any_timeout()");
+	}
+}
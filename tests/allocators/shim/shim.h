@@ -0,0 +1,29 @@
+/*-
+ * SPDX-License-Identifier: MIT
+ *
+ * Harness side of the linuxkpi shim.
+ */
+
+#ifndef _SHIM_H_
+#define	_SHIM_H_
+
+#include <linux/dma-fence.h>
+
+/* kmalloc() allocations not freed yet */
+extern long shim_allocated;
+/* fences not freed yet */
+extern long shim_fences;
+/* DRM_ERROR() messages printed */
+extern long shim_errors;
+
+/* Signal the oldest unsignaled fence, false if there is none. */
+bool shim_fence_progress(void);
+void shim_fence_signal_all(void);
+
+/*
+ * Called by waits when there is no fence left to signal, for the harness to
+ * free something it holds instead. Returns false if it had nothing left.
+ */
+extern bool (*shim_wait_hook)(void);
+
+#endif /* _SHIM_H_ */